@@ -9,6 +9,7 @@ struct API {
     static void init(size_t seed) {
 
         register_functions<SORTED>(seed);
+        register_cache(functions_init());
     }
 
     struct compiled_t {
@@ -0,0 +1,728 @@
+#ifndef __TAB_CACHE_H
+#define __TAB_CACHE_H
+
+namespace tab {
+
+// A columnar cache of a tab-separated file, the directory 'FILE.tabcache/', written
+// by 'tab --cache FILE'. Every column is stored in its own file: as native 64-bit
+// integers if every value of the column is a plain integer, otherwise as 32-bit ids
+// into a dictionary of the distinct values.
+//
+// A program that only looks at the input through 'cut(@,"\t",N)' with constant N
+// reads just the columns it uses; the lines are put back together from those columns,
+// with the unused columns left empty. An integer column read as 'int', 'uint' or 'real'
+// of its 'cut' is not put back into the lines at all: the number is taken as stored.
+// The cache is ignored if the file changed after the cache was built.
+//
+// The files in the cache directory:
+//
+//   meta     -- magic, then the stamp of the file (see funcs::FileStamp), number of rows,
+//               number of columns and a flag for rows with fewer columns as 64-bit
+//               words, then the kind of every column;
+//   fields   -- the number of columns in every row, as 32-bit words;
+//   col.N    -- the values of column N, as 64-bit integers or 32-bit dictionary ids;
+//   dict.N   -- the dictionary of column N: the number of values, their offsets in the
+//               file as 64-bit words, and the values.
+
+struct ColumnCache {
+
+    enum kind_t { INT = 0, STRING = 1 };
+
+    // The dictionary id stored for rows that do not have the column; integer columns store 0.
+    enum : uint32_t { NONE = 0xFFFFFFFF };
+
+    struct column_t {
+        kind_t kind;
+        funcs::MappedFile values;
+        funcs::MappedFile dict;
+    };
+
+    std::string dir;
+    UInt nrows;
+    bool ragged;
+    std::vector<kind_t> kinds;
+
+    funcs::MappedFile fields;
+    std::vector< std::unique_ptr<column_t> > columns;
+
+    ColumnCache() : nrows(0), ragged(false) {}
+
+    static std::string path(const std::string& fname) {
+        return fname + ".tabcache";
+    }
+
+    static std::string magic() {
+        return std::string("TABCACH2", 8);
+    }
+
+    // Only integers that print back exactly as they were written can be stored natively.
+    static bool plain_int(const char* b, const char* e, Int& out) {
+
+        bool neg = (b != e && *b == '-');
+        const char* p = b + (neg ? 1 : 0);
+
+        if (p == e || e - p > 18 || (*p == '0' && e - p > 1) || (neg && *p == '0'))
+            return false;
+
+        Int v = 0;
+
+        for (; p != e; ++p) {
+
+            if (*p < '0' || *p > '9')
+                return false;
+
+            v = v * 10 + (*p - '0');
+        }
+
+        out = (neg ? -v : v);
+        return true;
+    }
+
+    template <typename FUNC>
+    static void each_field(const char* b, const char* e, FUNC f) {
+
+        size_t j = 0;
+
+        while (1) {
+
+            const char* x = (const char*)::memchr(b, '\t', e - b);
+
+            if (!x) {
+                f(j, b, e);
+                return;
+            }
+
+            f(j, b, x);
+            b = x + 1;
+            ++j;
+        }
+    }
+
+    template <typename FUNC>
+    static void each_line(const funcs::MappedFile& f, FUNC func) {
+
+        const char* b = f.data;
+        const char* e = f.data + f.size;
+
+        while (b != e) {
+
+            const char* x = (const char*)::memchr(b, '\n', e - b);
+
+            func(b, x ? x : e);
+            b = (x ? x + 1 : e);
+        }
+    }
+
+    template <typename T>
+    static void write_all(std::ofstream& out, const std::vector<T>& v) {
+        out.write((const char*)v.data(), v.size() * sizeof(T));
+    }
+
+    static void build(const std::string& fname) {
+
+        funcs::MappedFile f;
+
+        if (!f.open(fname) || is_gzip(f.data, f.data + f.size))
+            throw std::runtime_error("Can only cache a regular, non-empty, uncompressed file: " + fname);
+
+        // Taken before reading, so that a change while the cache is built makes it stale.
+        funcs::FileStamp st;
+
+        if (!st.read(f.fd))
+            throw std::runtime_error("Could not stat file: " + fname);
+
+        // First pass: the number of columns and which of them are integers.
+        std::vector<UInt> present;
+        std::vector<bool> ints;
+        UInt nrows = 0;
+
+        each_line(f, [&](const char* b, const char* e) {
+
+            each_field(b, e, [&](size_t j, const char* fb, const char* fe) {
+
+                if (j >= present.size()) {
+                    present.resize(j + 1, 0);
+                    ints.resize(j + 1, true);
+                }
+
+                Int v;
+
+                ++present[j];
+                ints[j] = ints[j] && plain_int(fb, fe, v);
+            });
+
+            ++nrows;
+        });
+
+        std::string dir = path(fname);
+
+        if (::mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST)
+            throw std::runtime_error("Could not create cache directory: " + dir);
+
+        // The meta file is removed first and written last, so that a half-built cache is never used.
+        ::unlink((dir + "/meta").c_str());
+
+        size_t ncols = present.size();
+        bool ragged = false;
+
+        std::vector<kind_t> kinds(ncols);
+
+        for (size_t j = 0; j < ncols; ++j) {
+
+            ragged = ragged || (present[j] != nrows);
+            kinds[j] = (ints[j] ? INT : STRING);
+        }
+
+        // Second pass: write out the columns, a block of rows at a time.
+        static const size_t BLOCK = 64*1024;
+
+        std::vector< std::unique_ptr<std::ofstream> > outs;
+        std::vector< std::vector<Int> > intbufs(ncols);
+        std::vector< std::vector<uint32_t> > idbufs(ncols);
+        std::vector< std::unordered_map<std::string, uint32_t> > dicts(ncols);
+        std::vector< std::vector<std::string> > values(ncols);
+        std::vector<uint32_t> nfields;
+
+        for (size_t j = 0; j < ncols; ++j) {
+            outs.emplace_back(new std::ofstream(dir + "/col." + std::to_string(j), std::ios::binary | std::ios::trunc));
+        }
+
+        std::ofstream fieldsout(dir + "/fields", std::ios::binary | std::ios::trunc);
+
+        auto flush = [&]() {
+
+            for (size_t j = 0; j < ncols; ++j) {
+                write_all(*outs[j], intbufs[j]);
+                write_all(*outs[j], idbufs[j]);
+                intbufs[j].clear();
+                idbufs[j].clear();
+            }
+
+            write_all(fieldsout, nfields);
+            nfields.clear();
+        };
+
+        each_line(f, [&](const char* b, const char* e) {
+
+            size_t n = 0;
+
+            each_field(b, e, [&](size_t j, const char* fb, const char* fe) {
+
+                n = j + 1;
+
+                if (kinds[j] == INT) {
+                    Int v;
+                    plain_int(fb, fe, v);
+                    intbufs[j].push_back(v);
+                    return;
+                }
+
+                std::string s(fb, fe);
+                auto i = dicts[j].find(s);
+
+                if (i == dicts[j].end()) {
+
+                    if (values[j].size() >= NONE)
+                        throw std::runtime_error("Too many distinct values in a column to cache: " + fname);
+
+                    i = dicts[j].insert(std::make_pair(s, (uint32_t)values[j].size())).first;
+                    values[j].push_back(s);
+                }
+
+                idbufs[j].push_back(i->second);
+            });
+
+            for (size_t j = n; j < ncols; ++j) {
+
+                if (kinds[j] == INT) {
+                    intbufs[j].push_back(0);
+                } else {
+                    idbufs[j].push_back(NONE);
+                }
+            }
+
+            nfields.push_back(n);
+
+            if (nfields.size() >= BLOCK) {
+                flush();
+            }
+        });
+
+        flush();
+
+        for (size_t j = 0; j < ncols; ++j) {
+
+            outs[j]->close();
+
+            if (!*outs[j])
+                throw std::runtime_error("Could not write cache file in: " + dir);
+
+            if (kinds[j] != STRING)
+                continue;
+
+            std::ofstream out(dir + "/dict." + std::to_string(j), std::ios::binary | std::ios::trunc);
+
+            std::vector<UInt> offsets;
+            UInt off = sizeof(UInt) * (values[j].size() + 2);
+
+            offsets.push_back(values[j].size());
+
+            for (const std::string& s : values[j]) {
+                offsets.push_back(off);
+                off += s.size();
+            }
+
+            offsets.push_back(off);
+            write_all(out, offsets);
+
+            for (const std::string& s : values[j]) {
+                out.write(s.data(), s.size());
+            }
+
+            if (!out)
+                throw std::runtime_error("Could not write cache file in: " + dir);
+        }
+
+        if (!fieldsout)
+            throw std::runtime_error("Could not write cache file in: " + dir);
+
+        UInt head[3] = { nrows, ncols, ragged };
+
+        std::ofstream out(dir + "/meta", std::ios::binary | std::ios::trunc);
+
+        out.write(magic().data(), magic().size());
+        out.write((const char*)st.v, sizeof(st.v));
+        out.write((const char*)head, sizeof(head));
+
+        for (kind_t k : kinds) {
+            UInt x = k;
+            out.write((const char*)&x, sizeof(x));
+        }
+
+        if (!out)
+            throw std::runtime_error("Could not write cache file in: " + dir);
+    }
+
+    // Returns false if there is no cache, or it is stale.
+    bool load(const std::string& fname) {
+
+        dir = path(fname);
+
+        std::ifstream in(dir + "/meta", std::ios::binary);
+
+        if (!in)
+            return false;
+
+        std::string m(magic().size(), '\0');
+        funcs::FileStamp saved;
+        funcs::FileStamp st;
+        UInt head[3];
+
+        if (!st.read(fname))
+            return false;
+
+        in.read(&m[0], m.size());
+        in.read((char*)saved.v, sizeof(saved.v));
+        in.read((char*)head, sizeof(head));
+
+        if (!in || m != magic() || saved != st)
+            return false;
+
+        nrows = head[0];
+        ragged = head[2];
+        kinds.resize(head[1]);
+        columns.resize(head[1]);
+
+        for (kind_t& k : kinds) {
+            UInt x;
+            in.read((char*)&x, sizeof(x));
+            k = (kind_t)x;
+        }
+
+        if (!in)
+            return false;
+
+        return (!ragged || fields.open(dir + "/fields"));
+    }
+
+    // Maps the files of a column; an empty file cannot be mapped, but then there are no rows.
+    bool use(size_t j) {
+
+        if (j >= columns.size() || columns[j] || nrows == 0)
+            return true;
+
+        column_t* c = new column_t;
+        columns[j].reset(c);
+
+        c->kind = kinds[j];
+
+        if (!c->values.open(dir + "/col." + std::to_string(j)))
+            return false;
+
+        if (c->kind == STRING && !c->dict.open(dir + "/dict." + std::to_string(j)))
+            return false;
+
+        return (c->values.size == nrows * (c->kind == INT ? sizeof(Int) : sizeof(uint32_t)));
+    }
+
+    size_t num_fields(UInt row) const {
+
+        if (!ragged)
+            return kinds.size();
+
+        uint32_t n;
+        ::memcpy(&n, fields.data + row * sizeof(n), sizeof(n));
+        return n;
+    }
+
+    void append(size_t j, UInt row, std::string& out) const {
+
+        const column_t& c = *columns[j];
+
+        if (c.kind == INT) {
+
+            Int v;
+            ::memcpy(&v, c.values.data + row * sizeof(v), sizeof(v));
+
+            char tmp[NUMBER_SPACE];
+            out.append(tmp, format_int(v, tmp));
+            return;
+        }
+
+        uint32_t id;
+        ::memcpy(&id, c.values.data + row * sizeof(id), sizeof(id));
+
+        UInt b;
+        UInt e;
+        ::memcpy(&b, c.dict.data + (id + 1) * sizeof(UInt), sizeof(UInt));
+        ::memcpy(&e, c.dict.data + (id + 2) * sizeof(UInt), sizeof(UInt));
+
+        out.append(c.dict.data + b, e - b);
+    }
+
+    // The native value of column j; false if the column is not stored as integers, or
+    // the row does not have it.
+    bool get_int(size_t j, UInt row, Int& out) const {
+
+        if (j >= kinds.size() || kinds[j] != INT || j >= num_fields(row))
+            return false;
+
+        ::memcpy(&out, columns[j]->values.data + row * sizeof(out), sizeof(out));
+        return true;
+    }
+};
+
+// Finds the columns a program reads from its input, if it only reads the input through
+// 'cut(@,"\t",N)'. Any other use of the lines makes the whole line needed.
+struct ColumnUse {
+
+    std::unordered_set<UInt> lines;
+    std::vector<UInt> columns;
+
+    // The 'cut' calls, and the column each of them reads.
+    std::vector< std::pair<Command*, UInt> > cuts;
+
+    static bool is_cut(const std::vector<Command>& code, size_t i, UInt& col) {
+
+        if (i + 4 >= code.size())
+            return false;
+
+        const Command& delim = code[i + 1];
+        const Command& n = code[i + 2];
+        const Command& tup = code[i + 3];
+        const Command& fun = code[i + 4];
+
+        if (delim.cmd != Command::VAL || delim.arg.which != Atom::STRING || strings().get(delim.arg.str) != "\t")
+            return false;
+
+        if (n.cmd != Command::VAL || n.arg.which != Atom::UINT)
+            return false;
+
+        if (tup.cmd != Command::TUP || tup.arg.uint != 3 || fun.cmd != Command::FUN ||
+            fun.arg.which != Atom::STRING || strings().get(fun.arg.str) != "cut")
+            return false;
+
+        col = n.arg.uint;
+        return true;
+    }
+
+    // Counting the lines does not look at their contents. (Note that 'count' of a
+    // single line is its length, so only sequences of lines are allowed here.)
+    static bool is_count(const std::vector<Command>& code, size_t i) {
+
+        return (i + 1 < code.size() && code[i + 1].cmd == Command::FUN &&
+                code[i + 1].arg.which == Atom::STRING && strings().get(code[i + 1].arg.str) == "count");
+    }
+
+    bool scan(std::vector<Command>& code) {
+
+        for (size_t i = 0; i < code.size(); ++i) {
+
+            Command& c = code[i];
+
+            if (c.cmd == Command::VAR && lines.count(c.arg.uint)) {
+
+                UInt col;
+
+                if (c.type.type == Type::SEQ && i + 1 < code.size() &&
+                    (code[i + 1].cmd == Command::GEN || code[i + 1].cmd == Command::GEN_TRY)) {
+
+                    // The generator variable is bound to every line in turn.
+                    lines.insert(code[i + 1].arg.uint);
+
+                } else if (c.type.type == Type::ATOM && is_cut(code, i, col)) {
+
+                    if (std::find(columns.begin(), columns.end(), col) == columns.end()) {
+                        columns.push_back(col);
+                    }
+
+                    cuts.emplace_back(&code[i + 4], col);
+
+                } else if (c.type.type != Type::SEQ || !is_count(code, i)) {
+                    return false;
+                }
+            }
+
+            for (Command::Closure& clo : c.closure) {
+
+                if (!scan(clo.code))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // The top-level input is variable 0.
+    bool scan_program(std::vector<Command>& code) {
+
+        lines.clear();
+        columns.clear();
+        cuts.clear();
+        lines.insert(0);
+
+        return scan(code);
+    }
+};
+
+// A line read from the cache. It also knows its row, so that the fused calls below can
+// read the integer columns that are not put back into the line.
+struct CacheLine : public obj::String {
+
+    const ColumnCache* cache;
+
+    // The columns read as text in increasing order, and the number of fields in a line.
+    std::vector<size_t> cols;
+    size_t width;
+
+    UInt row;
+};
+
+// Puts the line of a row back together from the columns read as text.
+void cache_line(const obj::Object* in, obj::Object*& out) {
+
+    const CacheLine& src = obj::get<CacheLine>(in);
+    std::string& line = obj::get<obj::String>(out).v;
+    line.clear();
+
+    size_t n = std::min(src.width, src.cache->num_fields(src.row));
+
+    if (n > 0) {
+
+        size_t field = 0;
+
+        for (size_t j : src.cols) {
+
+            if (j >= n)
+                break;
+
+            line.append(j - field, '\t');
+            src.cache->append(j, src.row, line);
+            field = j;
+        }
+
+        line.append(n - 1 - field, '\t');
+    }
+}
+
+inline bool from_cached(Int v, Int& out) {
+    out = v;
+    return true;
+}
+
+inline bool from_cached(Int v, UInt& out) {
+    out = v;
+    return (v >= 0);
+}
+
+// Doubles are exact only up to 2^53; larger integers are rounded by the parser instead.
+inline bool from_cached(Int v, Real& out) {
+    out = v;
+    return (v <= ((Int)1 << 53) && v >= -((Int)1 << 53));
+}
+
+// 'int(cut(@,"\t",N))' and friends on a line read from the cache: the stored integer
+// is used as is. Anything else goes through the text, so that errors stay the same.
+template <typename T, void CONVERT(const obj::Object*, obj::Object*&)>
+void cache_number(const obj::Object* in, obj::Object*& out) {
+
+    const obj::Tuple& args = obj::get<obj::Tuple>(in);
+    const CacheLine& line = obj::get<CacheLine>(args.v[0]);
+    UInt nth = obj::get<obj::UInt>(args.v[2]).v;
+
+    Int v;
+
+    if (!line.cache->get_int(nth, line.row, v)) {
+        funcs::cutn_number<UInt, true, T, CONVERT>(in, out);
+        return;
+    }
+
+    if (from_cached(v, obj::get< obj::Atom<T> >(out).v))
+        return;
+
+    static thread_local obj::String field;
+    field.v.resize(NUMBER_SPACE);
+    field.v.resize(format_int(v, &field.v[0]));
+
+    CONVERT(&field, out);
+}
+
+void register_cache(Functions& funcs) {
+
+    funcs.add_fusion(cache_line, funcs::cutn_number<UInt, true, Int, funcs::string_to_int>,
+                     cache_number<Int, funcs::string_to_int>);
+    funcs.add_fusion(cache_line, funcs::cutn_number<UInt, true, UInt, funcs::string_to_uint>,
+                     cache_number<UInt, funcs::string_to_uint>);
+    funcs.add_fusion(cache_line, funcs::cutn_number<UInt, true, Real, funcs::string_to_real>,
+                     cache_number<Real, funcs::string_to_real>);
+}
+
+// Reads a range of rows from the cache, as lines with only the used columns filled in.
+struct SeqCache : public obj::SeqBase {
+
+    std::shared_ptr<ColumnCache> cache;
+
+    UInt row;
+    UInt end;
+    std::string name;
+    bool named;
+
+    CacheLine holder;
+
+    SeqCache(std::shared_ptr<ColumnCache> c, const std::vector<size_t>& u, size_t w, UInt b, UInt e, const std::string& fname) :
+        cache(c), row(b), end(e), name(fname), named(false) {
+
+        holder.cache = cache.get();
+        holder.cols = u;
+        holder.width = w;
+    }
+
+    obj::Object* next() {
+
+        if (!named) {
+            funcs::current_filename() = name;
+            named = true;
+        }
+
+        if (row >= end)
+            return nullptr;
+
+        holder.row = row;
+
+        obj::Object* out = &holder;
+        cache_line(&holder, out);
+
+        ++row;
+        return &holder;
+    }
+
+    UInt skip(UInt n) {
+
+        n = std::min(n, end - row);
+        row += n;
+        return n;
+    }
+};
+
+// Returns the inputs for the programs of the threads, one per program, reading from the
+// cache of the input file, or an empty list if the program or the options do not allow
+// using the cache. The programs are changed to read integer columns as stored.
+std::vector<obj::Object*> open_cache(const std::vector<std::string>& infiles, const std::vector< std::vector<Command>* >& codes) {
+
+    std::vector<obj::Object*> ret;
+
+    if (infiles.size() != 1 || wire_input() || funcs::record_size() || funcs::csv_records() || funcs::record_separator() != "\n" ||
+        funcs::follow().enabled || funcs::sampling().enabled())
+        return ret;
+
+    ColumnUse cu;
+
+    if (!cu.scan_program(*codes[0]))
+        return ret;
+
+    auto cache = std::make_shared<ColumnCache>();
+
+    if (!cache->load(infiles[0]))
+        return ret;
+
+    std::vector<size_t> cols;
+    size_t width = 0;
+
+    for (UInt col : cu.columns) {
+
+        if (!cache->use(col))
+            return ret;
+
+        // Lines must still have as many fields as the highest column asked for, so that
+        // 'cut' fails for missing columns just as it does on the original file.
+        width = std::max(width, std::min((size_t)col + 1, cache->kinds.size()));
+    }
+
+    std::unordered_set<UInt> text;
+
+    for (std::vector<Command>* code : codes) {
+
+        cu.scan_program(*code);
+
+        for (auto& c : cu.cuts) {
+
+            Functions::func_t f = functions().fused(cache_line, (Functions::func_t)c.first->function);
+
+            if (f && c.second < cache->kinds.size() && cache->kinds[c.second] == ColumnCache::INT) {
+                c.first->function = (void*)f;
+
+            } else {
+                text.insert(c.second);
+            }
+        }
+    }
+
+    for (UInt col : text) {
+
+        if (col < cache->kinds.size()) {
+            cols.push_back(col);
+        }
+    }
+
+    std::sort(cols.begin(), cols.end());
+
+    size_t nparts = codes.size();
+
+    for (size_t i = 0; i < nparts; ++i) {
+
+        UInt b = (cache->nrows * i) / nparts;
+        UInt e = (cache->nrows * (i + 1)) / nparts;
+
+        ret.push_back(new SeqCache(cache, cols, width, b, e, infiles[0]));
+    }
+
+    return ret;
+}
+
+void build_cache(const std::string& fname) {
+    ColumnCache::build(fname);
+}
+
+} // namespace tab
+
+#endif
@@ -12,10 +12,12 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <map>
+#include <limits>
 #include <initializer_list>
 #include <utility>
 #include <algorithm>
 #include <random>
+#include <chrono>
 
 #include <regex>
 
@@ -23,5 +25,19 @@
 #include <fstream>
 
 #include <cstring>
+#include <cstdint>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glob.h>
+
+#ifdef _REENTRANT
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
 
 #endif
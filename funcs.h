@@ -13,6 +13,8 @@ namespace funcs {
 #include "funcs/math.h"
 #include "funcs/head.h"
 #include "funcs/cutgrep.h"
+#include "funcs/csv.h"
+#include "funcs/json.h"
 #include "funcs/zip.h"
 #include "funcs/combo.h"
 #include "funcs/file.h"
@@ -31,6 +33,7 @@ namespace funcs {
 #include "funcs/hist.h"
 #include "funcs/uniques.h"
 #include "funcs/url.h"
+#include "funcs/weblog.h"
 #include "funcs/unflatten.h"
 
 } // namespace funcs
@@ -43,6 +46,7 @@ void register_functions(size_t seed) {
     Functions& funs = functions_init();
 
     funs.add_seqmaker(obj::make_seq_from<SORTED>);
+    funs.add_viewmaker(obj::make_view);
 
     funcs::register_index<SORTED>(funs);
     funcs::register_flatten<SORTED>(funs);
@@ -52,6 +56,8 @@ void register_functions(size_t seed) {
     funcs::register_math(funs);
     funcs::register_head<SORTED>(funs);
     funcs::register_cutgrep(funs);
+    funcs::register_csv(funs);
+    funcs::register_json(funs);
     funcs::register_zip<SORTED>(funs);
     funcs::register_combo(funs);
     funcs::register_file(funs);
@@ -70,6 +76,7 @@ void register_functions(size_t seed) {
     funcs::register_hist(funs);
     funcs::register_uniques(funs);
     funcs::register_url(funs);
+    funcs::register_weblog(funs);
     funcs::register_unflatten(funs);
 }
 
@@ -0,0 +1,163 @@
+#ifndef __TAB_FUNCS_CSV_H
+#define __TAB_FUNCS_CSV_H
+
+// Splits a CSV record (RFC 4180) into fields. A field in double quotes may contain
+// the delimiter, newlines and doubled quotes ("") standing for one quote character.
+// Quotes and delimiters are found with memchr(), which scans a whole vector register
+// at a time, so unquoted text is never looked at byte by byte.
+void csv_impl(const std::string& str, char delim, std::vector<std::string>& v) {
+
+    const char* p = str.data();
+    const char* e = p + str.size();
+
+    // A CRLF line ending is not part of the last field.
+    if (p != e && e[-1] == '\r') {
+        --e;
+    }
+
+    // The strings of the previous call are reused to avoid reallocating them.
+    size_t n = 0;
+
+    while (1) {
+
+        if (n == v.size()) {
+            v.emplace_back();
+        }
+
+        std::string& f = v[n];
+        f.clear();
+        ++n;
+
+        if (p != e && *p == '"') {
+
+            ++p;
+
+            while (1) {
+
+                const char* q = (const char*)::memchr(p, '"', e - p);
+
+                // An unterminated quote runs to the end of the record.
+                if (!q) {
+                    f.append(p, e);
+                    p = e;
+                    break;
+                }
+
+                f.append(p, q);
+                p = q + 1;
+
+                if (p != e && *p == '"') {
+                    f += '"';
+                    ++p;
+                    continue;
+                }
+
+                break;
+            }
+        }
+
+        // Anything between a closing quote and the delimiter is kept as it is.
+        const char* d = (const char*)::memchr(p, delim, e - p);
+
+        f.append(p, d ? d : e);
+
+        if (!d) break;
+
+        p = d + 1;
+    }
+
+    v.resize(n);
+}
+
+char csv_delimiter(const std::string& d) {
+
+    if (d.size() != 1)
+        throw std::runtime_error("The delimiter in 'csv' must be a single byte.");
+
+    return d[0];
+}
+
+void csv(const obj::Object* in, obj::Object*& out) {
+
+    csv_impl(obj::get<obj::String>(in).v, ',', obj::get< obj::ArrayAtom<std::string> >(out).v);
+}
+
+void csv_delim(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    csv_impl(obj::get<obj::String>(args.v[0]).v,
+             csv_delimiter(obj::get<obj::String>(args.v[1]).v),
+             obj::get< obj::ArrayAtom<std::string> >(out).v);
+}
+
+struct SeqCsv : public obj::SeqBase {
+
+    obj::Object* seq;
+    char delim;
+    obj::ArrayAtom<std::string> ret;
+
+    void do_wrap(obj::Object* s, char d) {
+        seq = s;
+        delim = d;
+    }
+
+    obj::Object* next() {
+
+        obj::Object* n = seq->next();
+
+        if (!n)
+            return n;
+
+        csv_impl(obj::get<obj::String>(n).v, delim, ret.v);
+        return &ret;
+    }
+};
+
+void csv_seq(const obj::Object* in, obj::Object*& out) {
+
+    obj::get<SeqCsv>(out).do_wrap((obj::Object*)in, ',');
+}
+
+void csv_seq_delim(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    obj::get<SeqCsv>(out).do_wrap(args.v[0], csv_delimiter(obj::get<obj::String>(args.v[1]).v));
+}
+
+Functions::func_t csv_checker(const Type& args, Type& ret, obj::Object*& obj) {
+
+    Type lines(Type::SEQ, { Type(Type::STRING) });
+
+    if (args == Type(Type::STRING)) {
+        ret = Type(Type::ARR, { Type::STRING });
+        return csv;
+    }
+
+    if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) })) {
+        ret = Type(Type::ARR, { Type::STRING });
+        return csv_delim;
+    }
+
+    if (args == lines) {
+        ret = Type(Type::SEQ, { Type(Type::ARR, { Type::STRING }) });
+        obj = new SeqCsv;
+        return csv_seq;
+    }
+
+    if (args == Type(Type::TUP, { lines, Type(Type::STRING) })) {
+        ret = Type(Type::SEQ, { Type(Type::ARR, { Type::STRING }) });
+        obj = new SeqCsv;
+        return csv_seq_delim;
+    }
+
+    return nullptr;
+}
+
+void register_csv(Functions& funcs) {
+
+    funcs.add_poly("csv", csv_checker);
+}
+
+#endif
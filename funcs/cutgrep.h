@@ -1,6 +1,41 @@
 #ifndef __TUP_FUNCS_CUTGREP_H
 #define __TUP_FUNCS_CUTGREP_H
 
+// Finds the first occurrence of a separator; memchr() and memmem() both scan
+// a whole vector register at a time in every libc worth using.
+inline const char* find_separator(const char* b, const char* e, const std::string& sep) {
+
+    if (sep.size() == 1) {
+        return (const char*)::memchr(b, sep[0], e - b);
+    }
+
+    return (const char*)::memmem(b, e - b, sep.data(), sep.size());
+}
+
+// Finds the last occurrence of a separator that ends before 'e'.
+inline const char* rfind_separator(const char* b, const char* e, const std::string& sep) {
+
+    if (sep.size() == 1) {
+        return (const char*)::memrchr(b, sep[0], e - b);
+    }
+
+    const char* x = std::find_end(b, e, sep.data(), sep.data() + sep.size());
+    return (x == e ? nullptr : x);
+}
+
+// With a delimiter of one byte given as a literal, BYTE is true and memchr() is called
+// directly, without looking at the delimiter length on every call.
+template <bool BYTE>
+inline const char* find_delimiter(const char* b, const char* e, const std::string& del) {
+    return (BYTE ? (const char*)::memchr(b, del[0], e - b) : find_separator(b, e, del));
+}
+
+template <bool BYTE>
+inline const char* rfind_delimiter(const char* b, const char* e, const std::string& del) {
+    return (BYTE ? (const char*)::memrchr(b, del[0], e - b) : rfind_separator(b, e, del));
+}
+
+template <bool BYTE>
 void cut(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
@@ -8,121 +43,181 @@ void cut(const obj::Object* in, obj::Object*& out) {
     const std::string& str = obj::get<obj::String>(args.v[0]).v;
     const std::string& del = obj::get<obj::String>(args.v[1]).v;
 
-    size_t N = str.size();
-    size_t M = del.size();
-
-    size_t prev = 0;
+    if (del.empty())
+        throw std::runtime_error("Empty delimiter in 'cut'");
 
     obj::ArrayAtom<std::string>& vv = obj::get< obj::ArrayAtom<std::string> >(out);
     std::vector<std::string>& v = vv.v;
-    
-    v.clear();
-    
-    for (size_t i = 0; i < N; ++i) {
 
-        bool matched = true;
+    // The strings of the previous call are reused to avoid reallocating them.
+    size_t n = 0;
 
-        for (size_t j = 0; j < M; ++j) {
+    const char* b = str.data();
+    const char* e = b + str.size();
 
-            if (i+j < N && str[i+j] == del[j])
-                continue;
-            
-            matched = false;
-            break;
-        }
+    while (1) {
 
-        if (matched) {
-            v.emplace_back(str.begin() + prev, str.begin() + i);
-            i += M;
-            prev = i;
-            --i;
+        const char* x = find_delimiter<BYTE>(b, e, del);
+
+        if (n < v.size()) {
+            v[n].assign(b, x ? x : e);
+        } else {
+            v.emplace_back(b, x ? x : e);
         }
+
+        ++n;
+
+        if (!x) break;
+
+        b = x + del.size();
     }
 
-    v.emplace_back(str.begin() + prev, str.end());
+    v.resize(n);
 }
 
-template <typename I>
-bool equal(I& b1, I& e1, I& b2, I& e2) {
+// Finds the bounds of the nth field without copying it.
+template <bool BYTE>
+void cutn_impl(const std::string& str, const std::string& del, UInt nth, const char*& fb, const char*& fe) {
 
-    if (e1 - b1 < e2 - b2)
-        return false;
+    const char* b = str.data();
+    const char* e = b + str.size();
 
-    return std::equal(b2, e2, b1);
-}
+    if (del.empty()) {
+        fb = fe = b;
+        return;
+    }
 
-template <typename I>
-void cutn_impl(I str_b, I str_e, I del_b, I del_e, size_t nth, std::string& out) {
+    for (UInt n = 0; ; ++n) {
 
-    auto prev = str_b;
+        const char* x = find_delimiter<BYTE>(b, e, del);
 
-    out.clear();
+        if (n == nth) {
+            fb = b;
+            fe = (x ? x : e);
+            return;
+        }
 
-    UInt nmatch = 0;
+        if (!x) break;
 
-    for (; str_b != str_e; ++str_b) {
+        b = x + del.size();
+    }
 
-        bool matched = equal(str_b, str_e, del_b, del_e);
+    throw std::runtime_error("Substring not found in 'cut'");
+}
 
-        if (matched) {
+// Counts fields from the end of the string: 0 is the last field.
+template <bool BYTE>
+void rcutn_impl(const std::string& str, const std::string& del, UInt nth, const char*& fb, const char*& fe) {
 
-            if (nth == nmatch) {
-                out.assign(prev, str_b);
-                return;
-            }
+    const char* b = str.data();
+    const char* e = b + str.size();
 
-            nmatch++;
-            str_b += (del_e - del_b);
-            prev = str_b;
-            --str_b;
-        }
+    if (del.empty()) {
+        fb = fe = b;
+        return;
     }
 
-    if (nth == nmatch) {
-        out.assign(prev, str_b);
-        return;
+    for (UInt n = 0; ; ++n) {
+
+        const char* x = rfind_delimiter<BYTE>(b, e, del);
+
+        if (n == nth) {
+            fb = (x ? x + del.size() : b);
+            fe = e;
+            return;
+        }
+
+        if (!x) break;
+
+        e = x;
     }
 
     throw std::runtime_error("Substring not found in 'cut'");
 }
 
-template <typename NUM>
-void cutn(const obj::Object* in, obj::Object*& out);
+template <bool BYTE>
+void cutn_field(const std::string& str, const std::string& del, UInt nth, const char*& fb, const char*& fe) {
 
-template <>
-void cutn<UInt>(const obj::Object* in, obj::Object*& out) {
+    cutn_impl<BYTE>(str, del, nth, fb, fe);
+}
 
-    obj::Tuple& args = obj::get<obj::Tuple>(in);
+template <bool BYTE>
+void cutn_field(const std::string& str, const std::string& del, Int nth, const char*& fb, const char*& fe) {
 
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
-    const std::string& del = obj::get<obj::String>(args.v[1]).v;
-    UInt nth = obj::get<obj::UInt>(args.v[2]).v;
+    if (nth >= 0) {
+        cutn_impl<BYTE>(str, del, nth, fb, fe);
+
+    } else {
+        rcutn_impl<BYTE>(str, del, -1 - nth, fb, fe);
+    }
+}
+
+template <typename NUM, bool BYTE>
+void cutn_field(const obj::Tuple& args, const char*& fb, const char*& fe) {
+
+    cutn_field<BYTE>(obj::get<obj::String>(args.v[0]).v,
+                     obj::get<obj::String>(args.v[1]).v,
+                     obj::get< obj::Atom<NUM> >(args.v[2]).v,
+                     fb, fe);
+}
+
+template <typename NUM, bool BYTE>
+void cutn(const obj::Object* in, obj::Object*& out) {
+
+    const char* fb;
+    const char* fe;
+
+    cutn_field<NUM, BYTE>(obj::get<obj::Tuple>(in), fb, fe);
+
+    obj::get<obj::String>(out).v.assign(fb, fe);
+}
+
+// 'cutn' for a result that is consumed right away (see Functions::viewers): the field
+// is returned as a view into the argument string instead of being copied.
+template <typename NUM, bool BYTE>
+void cutn_view(const obj::Object* in, obj::Object*& out) {
 
-    std::string& v = obj::get<obj::String>(out).v;
+    obj::StringView& v = obj::get<obj::StringView>(out);
 
-    cutn_impl(str.begin(), str.end(), del.begin(), del.end(), nth, v);
+    cutn_field<NUM, BYTE>(obj::get<obj::Tuple>(in), v.b, v.e);
 }
 
+template <typename T>
+bool parse_field(const char* b, const char* e, T& out);
+
 template <>
-void cutn<Int>(const obj::Object* in, obj::Object*& out) {
+bool parse_field(const char* b, const char* e, Int& out) {
+    return parse_int(b, e, out);
+}
 
-    obj::Tuple& args = obj::get<obj::Tuple>(in);
+template <>
+bool parse_field(const char* b, const char* e, UInt& out) {
+    return parse_uint(b, e, out);
+}
 
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
-    const std::string& del = obj::get<obj::String>(args.v[1]).v;
-    Int nth = obj::get<obj::Int>(args.v[2]).v;
+template <>
+bool parse_field(const char* b, const char* e, Real& out) {
+    return parse_real(b, e, out);
+}
 
-    std::string& v = obj::get<obj::String>(out).v;
+// 'int(cut(s,d,n))', 'uint(cut(s,d,n))' and 'real(cut(s,d,n))' fused into one call by
+// the optimizer: the number is parsed in place instead of copying out the field first.
+// Anything unusual is handed to the unfused conversion, so that errors stay the same.
+template <typename NUM, bool BYTE, typename T, void CONVERT(const obj::Object*, obj::Object*&)>
+void cutn_number(const obj::Object* in, obj::Object*& out) {
 
-    if (nth >= 0) {
+    const char* fb;
+    const char* fe;
 
-        cutn_impl(str.begin(), str.end(), del.begin(), del.end(), nth, v);
+    cutn_field<NUM, BYTE>(obj::get<obj::Tuple>(in), fb, fe);
 
-    } else {
+    if (parse_field(fb, fe, obj::get< obj::Atom<T> >(out).v))
+        return;
 
-        cutn_impl(str.rbegin(), str.rend(), del.rbegin(), del.rend(), -1 - nth, v);
-        std::reverse(v.begin(), v.end());
-    }
+    static thread_local obj::String field;
+    field.v.assign(fb, fe);
+
+    CONVERT(&field, out);
 }
 
 template <void CUTTER(const obj::Object*, obj::Object*&)>
@@ -158,32 +253,35 @@ void cut_seq(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
 
-    SeqCut<cut>& ret = obj::get< SeqCut<cut> >(out);
+    SeqCut< cut<false> >& ret = obj::get< SeqCut< cut<false> > >(out);
 
     ret.do_wrap(&args);
 }
 
 Functions::func_t cut_checker(const Type& args, Type& ret, obj::Object*& obj) {
 
+    const std::string* del = (args.type == Type::TUP && args.tuple->size() >= 2 ? literal_string(args.tuple->at(1)) : nullptr);
+    bool byte = (del && del->size() == 1);
+
     if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) })) {
         ret = Type(Type::ARR, { Type::STRING });
-        return cut;
+        return (byte ? cut<true> : cut<false>);
     }
 
     if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::UINT) })) {
         ret = Type(Type::STRING);
-        return cutn<UInt>;
+        return (byte ? cutn<UInt, true> : cutn<UInt, false>);
     }
 
     if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::INT) })) {
         ret = Type(Type::STRING);
-        return cutn<Int>;
+        return (byte ? cutn<Int, true> : cutn<Int, false>);
     }
 
     if (args == Type(Type::TUP, { Type(Type::SEQ, { Type(Type::STRING) }), Type(Type::STRING) })) {
         ret = Type(Type::SEQ, { Type(Type::ARR, { Type::STRING }) });
 
-        obj = new SeqCut<cut>;
+        obj = new SeqCut< cut<false> >;
         return cut_seq;
     }
 
@@ -192,63 +290,129 @@ Functions::func_t cut_checker(const Type& args, Type& ret, obj::Object*& obj) {
 
 struct RegexCache {
 
-    std::unordered_map<std::string, std::regex> cache;
+    std::unordered_map<std::string, Regex> cache;
 
-    const std::regex& get(const std::string& s) {
+    Regex& get(const std::string& s) {
 
         auto i = cache.find(s);
 
         if (i == cache.end()) {
-            i = cache.insert(i, std::make_pair(s, std::regex(s, std::regex_constants::optimize)));
+            i = cache.emplace(std::piecewise_construct, std::forward_as_tuple(s), std::forward_as_tuple(s)).first;
         }
 
         return i->second;
     }
 };
 
-const std::regex& regex_cache(const std::string& s) {
+Regex& regex_cache(const std::string& s) {
     static thread_local RegexCache cache;
     return cache.get(s);
 }
 
+// A pattern given as a literal is compiled once, when the program is type-checked,
+// and kept in the result object of the call.
+template <bool REGEX>
+struct Pattern;
+
+template <>
+struct Pattern<true> {
+
+    Regex rx;
+
+    Pattern(const std::string& p) : rx(p) {}
+
+    Regex& get() { return rx; }
+};
+
+template <>
+struct Pattern<false> {
+
+    std::string substr;
+
+    Pattern(const std::string& p) : substr(p) {}
+
+    const std::string& get() const { return substr; }
+};
+
+template <bool REGEX, typename T>
+struct WithPattern : public T {
+
+    Pattern<REGEX> pattern;
+
+    WithPattern(const std::string& p) : pattern(p) {}
+};
+
+// Returns nullptr if the argument is not a literal, or if it is not a valid regex; the
+// error is then reported when the call runs, as for patterns computed at runtime.
+template <bool REGEX, typename T>
+WithPattern<REGEX, T>* make_pattern(const Type& arg) {
+
+    const std::string* p = literal_string(arg);
+
+    if (!p)
+        return nullptr;
+
+    try {
+        return new WithPattern<REGEX, T>(*p);
+
+    } catch (std::regex_error& e) {
+        return nullptr;
+    }
+}
+
 template <bool REGEX>
 struct Searcher;
 
 template <>
 struct Searcher<true> {
 
-    std::reference_wrapper<const std::regex> rx;
+    std::reference_wrapper<Regex> rx;
+
+    Searcher(const std::string& p) : rx(std::ref(regex_cache(p))) {}
 
-    Searcher(const std::string& p) : rx(std::cref(regex_cache(p))) {}
+    Searcher(Regex& r) : rx(std::ref(r)) {}
+
+    bool matches(const char* b, const char* e) {
+        return rx.get().contains(b, e);
+    }
 
     bool matches(const std::string& s) {
-        return std::regex_search(s, rx.get());
+        return matches(s.data(), s.data() + s.size());
     }
 
-    void matches(const std::string& s, std::vector<std::string>& v) {
+    bool matches(const obj::StringView& s) {
+        return matches(s.b, s.e);
+    }
 
-        std::sregex_iterator iter(s.begin(), s.end(), rx);
-        std::sregex_iterator end;
+    // With groups, the groups of each match are returned instead of the whole match.
+    void matches(const char* b, const char* e, std::vector<std::string>& v) {
 
-        while (iter != end) {
+        Regex& r = rx.get();
+        const std::vector<const char*>& m = r.match;
 
-            if (iter->size() == 1) {
+        r.each(b, e, [&]() {
+
+            if (m.size() == 2) {
+                v.emplace_back(m[0], m[1]);
+                return;
+            }
 
-                v.emplace_back(iter->str());
+            for (size_t i = 2; i < m.size(); i += 2) {
 
-            } else if (iter->size() > 1) {
-                auto subi = iter->begin();
-                auto sube = iter->end();
-                ++subi;
-            
-                while (subi != sube) {
-                    v.emplace_back(subi->str());
-                    ++subi;
-                }
+                if (m[i])
+                    v.emplace_back(m[i], m[i + 1]);
+                else
+                    v.emplace_back();
             }
+        });
+    }
 
-            ++iter;
-        }
+    void matches(const std::string& s, std::vector<std::string>& v) {
+        matches(s.data(), s.data() + s.size(), v);
+    }
+
+    void matches(const obj::StringView& s, std::vector<std::string>& v) {
+        matches(s.b, s.e, v);
     }
 };
 
@@ -267,7 +431,17 @@ struct Searcher<false> {
         return (::strstr(s.data(), substr.get().data()) != nullptr);
     }
 
-    void matches(const std::string& s, std::vector<std::string>& v) {
+    // A view is not NUL-terminated; both strings are cut at a NUL as strstr() would do.
+    bool matches(const obj::StringView& s) {
+
+        const char* e = (const char*)::memchr(s.b, '\0', s.e - s.b);
+        const char* p = substr.get().data();
+
+        return (::memmem(s.b, (e ? e : s.e) - s.b, p, ::strlen(p)) != nullptr);
+    }
+
+    template <typename S>
+    void matches(const S& s, std::vector<std::string>& v) {
 
         if (matches(s)) {
             v.emplace_back(substr);
@@ -275,12 +449,24 @@ struct Searcher<false> {
     }
 };
 
-template <bool REGEX>
+// The string argument of 'grep' and 'grepif', or a view of it; see cutn_view.
+template <bool VIEW>
+using Subject = typename std::conditional<VIEW, obj::StringView, obj::String>::type;
+
+inline const std::string& subject(const obj::String& s) {
+    return s.v;
+}
+
+inline const obj::StringView& subject(const obj::StringView& s) {
+    return s;
+}
+
+template <bool REGEX, bool VIEW = false>
 void grep(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
     
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
+    const auto& str = subject(obj::get< Subject<VIEW> >(args.v[0]));
     const std::string& pattern = obj::get<obj::String>(args.v[1]).v;
 
     obj::ArrayAtom<std::string>& vv = obj::get< obj::ArrayAtom<std::string> >(out);
@@ -293,12 +479,40 @@ void grep(const obj::Object* in, obj::Object*& out) {
     searcher.matches(str, v);
 }
 
+template <bool REGEX, bool VIEW = false>
+void grep_literal(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    const auto& str = subject(obj::get< Subject<VIEW> >(args.v[0]));
+
+    WithPattern< REGEX, obj::ArrayAtom<std::string> >& ret = obj::get< WithPattern< REGEX, obj::ArrayAtom<std::string> > >(out);
+
+    ret.v.clear();
+
+    Searcher<REGEX> searcher(ret.pattern.get());
+
+    searcher.matches(str, ret.v);
+}
+
 template <bool REGEX>
+Functions::func_t grep_checker(const Type& args, Type& ret, obj::Object*& obj) {
+
+    if (args != Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) }))
+        return nullptr;
+
+    ret = Type(Type::ARR, { Type::STRING });
+    obj = make_pattern< REGEX, obj::ArrayAtom<std::string> >(args.tuple->at(1));
+
+    return (obj ? grep_literal<REGEX> : grep<REGEX>);
+}
+
+template <bool REGEX, bool VIEW = false>
 void grepif(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
     
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
+    const auto& str = subject(obj::get< Subject<VIEW> >(args.v[0]));
     const std::string& pattern = obj::get<obj::String>(args.v[1]).v;
 
     obj::UInt& res = obj::get<obj::UInt>(out);
@@ -310,6 +524,20 @@ void grepif(const obj::Object* in, obj::Object*& out) {
     res.v = (found ? 1 : 0);
 }
 
+template <bool REGEX, bool VIEW = false>
+void grepif_literal(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    const auto& str = subject(obj::get< Subject<VIEW> >(args.v[0]));
+
+    WithPattern<REGEX, obj::UInt>& res = obj::get< WithPattern<REGEX, obj::UInt> >(out);
+
+    Searcher<REGEX> searcher(res.pattern.get());
+
+    res.v = (searcher.matches(str) ? 1 : 0);
+}
+
 template <bool REGEX>
 struct SeqGrepIf : public obj::SeqBase {
 
@@ -371,7 +599,9 @@ Functions::func_t grepif_checker(const Type& args, Type& ret, obj::Object*& obj)
     if (check_string(t1)) {
 
         ret = Type(Type::UINT);
-        return grepif<REGEX>;
+        obj = make_pattern<REGEX, obj::UInt>(t2);
+
+        return (obj ? grepif_literal<REGEX> : grepif<REGEX>);
     }
 
     if (t1.type == Type::SEQ && t1.tuple && t1.tuple->size() == 1) {
@@ -390,6 +620,88 @@ Functions::func_t grepif_checker(const Type& args, Type& ret, obj::Object*& obj)
     return nullptr;
 }
 
+// Appends 'fmt' with the substitutions of std::regex_replace: $& is the match, $n and
+// $nn are groups, $` and $' the text before and after the match, and $$ is '$'.
+void replace_format(const std::vector<const char*>& m, const char* prefix, const char* end,
+                    const std::string& fmt, std::string& res) {
+
+    const char* f = fmt.data();
+    const char* fe = f + fmt.size();
+
+    while (1) {
+
+        const char* d = (const char*)::memchr(f, '$', fe - f);
+
+        if (!d) {
+            res.append(f, fe);
+            return;
+        }
+
+        res.append(f, d);
+        f = d + 1;
+
+        if (f == fe) {
+            res += '$';
+            return;
+        }
+
+        size_t group;
+
+        if (*f == '$') {
+            res += '$';
+            ++f;
+            continue;
+
+        } else if (*f == '&') {
+            group = 0;
+            ++f;
+
+        } else if (*f == '`') {
+            res.append(prefix, m[0]);
+            ++f;
+            continue;
+
+        } else if (*f == '\'') {
+            res.append(m[1], end);
+            ++f;
+            continue;
+
+        } else if (*f >= '0' && *f <= '9') {
+            group = *f - '0';
+            ++f;
+
+            if (f != fe && *f >= '0' && *f <= '9') {
+                group = group * 10 + (*f - '0');
+                ++f;
+            }
+
+        } else {
+            res += '$';
+            continue;
+        }
+
+        if (2 * group < m.size() && m[2 * group])
+            res.append(m[2 * group], m[2 * group + 1]);
+    }
+}
+
+void replace_impl(const std::string& str, Regex& r, const std::string& rep, std::string& res) {
+
+    res.clear();
+
+    const char* b = str.data();
+    const char* e = b + str.size();
+    const char* prefix = b;
+
+    r.each(b, e, [&]() {
+        res.append(prefix, r.match[0]);
+        replace_format(r.match, prefix, e, rep, res);
+        prefix = r.match[1];
+    });
+
+    res.append(prefix, e);
+}
+
 void replace(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
@@ -398,46 +710,53 @@ void replace(const obj::Object* in, obj::Object*& out) {
     const std::string& regex = obj::get<obj::String>(args.v[1]).v;
     const std::string& rep = obj::get<obj::String>(args.v[2]).v;
     
-    std::string& res = obj::get<obj::String>(out).v;
+    replace_impl(str, regex_cache(regex), rep, obj::get<obj::String>(out).v);
+}
 
-    const std::regex& r = regex_cache(regex);
+void replace_literal(const obj::Object* in, obj::Object*& out) {
 
-    res.clear();
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    const std::string& str = obj::get<obj::String>(args.v[0]).v;
+    const std::string& rep = obj::get<obj::String>(args.v[2]).v;
 
-    std::regex_replace(std::back_insert_iterator<std::string>(res), str.begin(), str.end(), r, rep);
+    WithPattern<true, obj::String>& res = obj::get< WithPattern<true, obj::String> >(out);
+
+    replace_impl(str, res.pattern.get(), rep, res.v);
 }
 
-void recut(const obj::Object* in, obj::Object*& out) {
+Functions::func_t replace_checker(const Type& args, Type& ret, obj::Object*& obj) {
 
-    obj::Tuple& args = obj::get<obj::Tuple>(in);
+    if (args != Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::STRING) }))
+        return nullptr;
 
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
-    const std::string& regex = obj::get<obj::String>(args.v[1]).v;
+    ret = Type(Type::STRING);
+    obj = make_pattern<true, obj::String>(args.tuple->at(1));
 
-    obj::ArrayAtom<std::string>& vv = obj::get< obj::ArrayAtom<std::string> >(out);
-    std::vector<std::string>& v = vv.v;
+    return (obj ? replace_literal : replace);
+}
+
+void recut_impl(const std::string& str, Regex& r, std::vector<std::string>& v) {
 
     v.clear();
 
-    const std::regex& r = regex_cache(regex);
+    const char* iter = str.data();
+    const char* end = iter + str.size();
+    const std::vector<const char*>& match = r.match;
 
-    auto iter = str.begin();
-    auto end = str.end();
-    std::smatch match;
-    
     while (1) {
 
-        if (!std::regex_search(iter, end, match, r)) {
+        if (!r.search(iter, end)) {
             v.emplace_back(iter, end);
             break;
         }
 
-        v.emplace_back(iter, match[0].first);
+        v.emplace_back(iter, match[0]);
 
-        if (iter == match[0].second)
+        if (iter == match[1])
             throw std::runtime_error("Cannot use an empty match as a delimiter in 'recut'.");
 
-        iter = match[0].second;
+        iter = match[1];
 
         if (iter == end) {
             v.emplace_back();
@@ -446,40 +765,31 @@ void recut(const obj::Object* in, obj::Object*& out) {
     }
 }
 
-void recutn(const obj::Object* in, obj::Object*& out) {
-
-    obj::Tuple& args = obj::get<obj::Tuple>(in);
+void recutn_impl(const std::string& str, Regex& r, UInt nth, std::string& v) {
 
-    const std::string& str = obj::get<obj::String>(args.v[0]).v;
-    const std::string& regex = obj::get<obj::String>(args.v[1]).v;
-    UInt nth = obj::get<obj::UInt>(args.v[2]).v;
-    
-    std::string& v = obj::get<obj::String>(out).v;
     v.clear();
 
-    const std::regex& r = regex_cache(regex);
-
     UInt nmatch = 0;
 
-    auto iter = str.begin();
-    auto end = str.end();
-    std::smatch match;
-    
+    const char* iter = str.data();
+    const char* end = iter + str.size();
+    const std::vector<const char*>& match = r.match;
+
     while (iter != end) {
 
-        if (!std::regex_search(iter, end, match, r)) {
+        if (!r.search(iter, end)) {
             break;
         }
 
-        if (iter == match[0].second)
+        if (iter == match[1])
             throw std::runtime_error("Cannot use an empty match as a delimiter in 'recut'.");
 
         if (nmatch == nth) {
-            v.assign(iter, match[0].first);
+            v.assign(iter, match[0]);
             return;
         }
-        
-        iter = match[0].second;
+
+        iter = match[1];
         ++nmatch;
     }
 
@@ -491,6 +801,45 @@ void recutn(const obj::Object* in, obj::Object*& out) {
     throw std::runtime_error("Substring not found in 'recut'");
 }
 
+void recut(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    const std::string& str = obj::get<obj::String>(args.v[0]).v;
+    const std::string& regex = obj::get<obj::String>(args.v[1]).v;
+
+    recut_impl(str, regex_cache(regex), obj::get< obj::ArrayAtom<std::string> >(out).v);
+}
+
+void recut_literal(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    WithPattern< true, obj::ArrayAtom<std::string> >& ret = obj::get< WithPattern< true, obj::ArrayAtom<std::string> > >(out);
+
+    recut_impl(obj::get<obj::String>(args.v[0]).v, ret.pattern.get(), ret.v);
+}
+
+void recutn(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    const std::string& str = obj::get<obj::String>(args.v[0]).v;
+    const std::string& regex = obj::get<obj::String>(args.v[1]).v;
+    UInt nth = obj::get<obj::UInt>(args.v[2]).v;
+
+    recutn_impl(str, regex_cache(regex), nth, obj::get<obj::String>(out).v);
+}
+
+void recutn_literal(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    WithPattern<true, obj::String>& ret = obj::get< WithPattern<true, obj::String> >(out);
+
+    recutn_impl(obj::get<obj::String>(args.v[0]).v, ret.pattern.get(), obj::get<obj::UInt>(args.v[2]).v, ret.v);
+}
+
 void recut_seq(const obj::Object* in, obj::Object*& out) {
 
     obj::Tuple& args = obj::get<obj::Tuple>(in);
@@ -504,12 +853,16 @@ Functions::func_t recut_checker(const Type& args, Type& ret, obj::Object*& obj)
 
     if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) })) {
         ret = Type(Type::ARR, { Type::STRING });
-        return recut;
+        obj = make_pattern< true, obj::ArrayAtom<std::string> >(args.tuple->at(1));
+
+        return (obj ? recut_literal : recut);
     }
 
     if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::UINT) })) {
         ret = Type(Type::STRING);
-        return recutn;
+        obj = make_pattern<true, obj::String>(args.tuple->at(1));
+
+        return (obj ? recutn_literal : recutn);
     }
 
     if (args == Type(Type::TUP, { Type(Type::SEQ, { Type(Type::STRING) }), Type(Type::STRING) })) {
@@ -522,33 +875,50 @@ Functions::func_t recut_checker(const Type& args, Type& ret, obj::Object*& obj)
     return nullptr;
 }
 
+template <typename NUM, bool BYTE>
+void add_cutn_fusions(Functions& funcs) {
+
+    funcs.add_fusion(cutn<NUM, BYTE>, string_to_int, cutn_number<NUM, BYTE, Int, string_to_int>);
+    funcs.add_fusion(cutn<NUM, BYTE>, string_to_uint, cutn_number<NUM, BYTE, UInt, string_to_uint>);
+    funcs.add_fusion(cutn<NUM, BYTE>, string_to_real, cutn_number<NUM, BYTE, Real, string_to_real>);
+
+    funcs.add_viewer(cutn<NUM, BYTE>, cutn_view<NUM, BYTE>);
+}
+
+template <bool REGEX>
+void add_grep_view_takers(Functions& funcs) {
+
+    funcs.add_view_taker(grep<REGEX>, 0, grep<REGEX, true>);
+    funcs.add_view_taker(grep_literal<REGEX>, 0, grep_literal<REGEX, true>);
+    funcs.add_view_taker(grepif<REGEX>, 0, grepif<REGEX, true>);
+    funcs.add_view_taker(grepif_literal<REGEX>, 0, grepif_literal<REGEX, true>);
+}
+
 void register_cutgrep(Functions& funcs) {
 
     funcs.add_poly("cut", cut_checker);
     funcs.add_poly("split", cut_checker);
 
-    funcs.add("grep",
-              Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) }),
-              Type(Type::ARR, { Type::STRING }),
-              grep<true>);
+    funcs.add_poly("grep", grep_checker<true>);
 
     funcs.add_poly("grepif", grepif_checker<true>);
 
-    funcs.add("find",
-              Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) }),
-              Type(Type::ARR, { Type::STRING }),
-              grep<false>);
+    funcs.add_poly("find", grep_checker<false>);
 
     funcs.add_poly("findif", grepif_checker<false>);
 
-    funcs.add("replace",
-              Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::STRING) }),
-              Type(Type::STRING),
-              replace);
+    funcs.add_poly("replace", replace_checker);
 
     funcs.add_poly("recut", recut_checker);
     funcs.add_poly("resplit", recut_checker);
 
+    add_cutn_fusions<UInt, false>(funcs);
+    add_cutn_fusions<UInt, true>(funcs);
+    add_cutn_fusions<Int, false>(funcs);
+    add_cutn_fusions<Int, true>(funcs);
+
+    add_grep_view_takers<true>(funcs);
+    add_grep_view_takers<false>(funcs);
 }
 
 #endif
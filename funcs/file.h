@@ -1,73 +1,859 @@
 #ifndef __TAB_FUNCS_FILE_H
 #define __TAB_FUNCS_FILE_H
 
+struct MappedFile {
+
+    int fd;
+    const char* data;
+    size_t size;
+
+    MappedFile() : fd(-1), data(nullptr), size(0) {}
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Returns false if the file is not a regular file or cannot be mapped;
+    // the caller should fall back to reading it as a stream.
+    bool open(const std::string& fname) {
+
+        close();
+
+        fd = ::open(fname.c_str(), O_RDONLY);
+
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            close();
+            return false;
+        }
+
+        void* m = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (m == MAP_FAILED) {
+            close();
+            return false;
+        }
+
+        ::madvise(m, st.st_size, MADV_SEQUENTIAL);
+
+        data = (const char*)m;
+        size = st.st_size;
+        return true;
+    }
+
+    void close() {
+
+        if (data) {
+            ::munmap((void*)data, size);
+            data = nullptr;
+            size = 0;
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+#ifdef _REENTRANT
+
+// Double-buffered reading from a stream: a background thread fills the next
+// block while the caller is still parsing the current one.
+struct ReadAhead {
+
+    static const size_t BUFSIZE = 1024*1024;
+
+    struct state_t {
+        std::istream& infile;
+        std::unique_ptr<char[]> bufs[2];
+        size_t sizes[2];
+        bool full[2];
+        bool finished;
+        bool stop;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        state_t(std::istream& i) : infile(i), sizes{0, 0}, full{false, false}, finished(false), stop(false) {
+            bufs[0].reset(new char[BUFSIZE]);
+            bufs[1].reset(new char[BUFSIZE]);
+        }
+    };
+
+    std::shared_ptr<state_t> state;
+    size_t cur;
+    bool holding;
+
+    // The thread owns a reference to the state and is detached, since it might be
+    // blocked reading a pipe that will never be closed.
+    static void fill(std::shared_ptr<state_t> st) {
+
+        size_t i = 0;
+
+        while (1) {
+            {
+                std::unique_lock<std::mutex> l(st->mutex);
+
+                while (st->full[i] && !st->stop) {
+                    st->cv.wait(l);
+                }
+
+                if (st->stop)
+                    break;
+            }
+
+            st->infile.read(st->bufs[i].get(), BUFSIZE);
+            size_t n = st->infile.gcount();
+            bool eof = !(st->infile);
+
+            {
+                std::unique_lock<std::mutex> l(st->mutex);
+                st->sizes[i] = n;
+                st->full[i] = true;
+                st->cv.notify_all();
+            }
+
+            if (eof)
+                break;
+
+            i = 1 - i;
+        }
+
+        std::unique_lock<std::mutex> l(st->mutex);
+        st->finished = true;
+        st->cv.notify_all();
+    }
+
+    ReadAhead(std::istream& infile) : state(std::make_shared<state_t>(infile)), cur(1), holding(false) {
+        std::thread(fill, state).detach();
+    }
+
+    ~ReadAhead() {
+        std::unique_lock<std::mutex> l(state->mutex);
+        state->stop = true;
+        state->cv.notify_all();
+    }
+
+    // Returns the next filled block, handing the previous one back to the reading thread.
+    std::pair<const char*, size_t> next() {
+
+        std::unique_lock<std::mutex> l(state->mutex);
+
+        if (holding) {
+            state->full[cur] = false;
+            holding = false;
+            state->cv.notify_all();
+        }
+
+        size_t i = 1 - cur;
+
+        while (!state->full[i] && !state->finished) {
+            state->cv.wait(l);
+        }
+
+        if (!state->full[i])
+            return std::make_pair(nullptr, 0);
+
+        cur = i;
+        holding = true;
+
+        return std::make_pair(state->bufs[i].get(), state->sizes[i]);
+    }
+};
+
+#endif
+
+// The record separator for input files, set with the '-R' command-line option.
+std::string& record_separator() {
+    static std::string ret("\n");
+    return ret;
+}
+
+// The size of fixed-width binary input records, set with the '-B' command-line option;
+// 0 means the input is split on the record separator instead.
+size_t& record_size() {
+    static size_t ret = 0;
+    return ret;
+}
+
+// CSV records, set with '-R csv': lines are joined while a double quote is left open,
+// so that quoted fields may contain newlines.
+bool& csv_records() {
+    static bool ret = false;
+    return ret;
+}
+
+// Follow mode, set with the '-F' command-line option: the input file is read as it
+// grows, like 'tail -f', and the result so far is printed every N seconds or N lines.
+struct Follow {
+
+    typedef std::chrono::steady_clock clock_t;
+
+    bool enabled;
+    double seconds;
+    size_t lines;
+
+    // Prints a snapshot of the current result; empty if the result cannot be snapshotted.
+    std::function<void()> snapshot;
+
+    // The printer of results that stream out, if any; its buffer is written out whenever
+    // the reader goes idle, since the newest line is only ended by the next one.
+    obj::Printer* printer;
+
+    size_t count;
+    bool dirty;
+    clock_t::time_point last;
+
+    Follow() : enabled(false), seconds(1), lines(0), printer(nullptr), count(0), dirty(false), last(clock_t::now()) {}
+
+    void fire() {
+
+        if (snapshot && dirty) {
+            snapshot();
+        }
+
+        count = 0;
+        dirty = false;
+        last = clock_t::now();
+    }
+
+    bool due() const {
+        return std::chrono::duration<double>(clock_t::now() - last).count() >= seconds;
+    }
+
+    // Called for every record read; the clock is only looked at every so often.
+    void tick() {
+
+        dirty = true;
+        ++count;
+
+        if (lines > 0) {
+
+            if (count >= lines)
+                fire();
+
+        } else if ((count & 0xFF) == 0 && due()) {
+            fire();
+        }
+    }
+
+    // Called when the reader has caught up with the end of the file and is about to wait.
+    void idle() {
+
+        if (lines == 0 && due()) {
+            fire();
+        }
+
+        if (printer) {
+            printer->flush();
+        }
+
+        ::fflush(stdout);
+    }
+};
+
+Follow& follow() {
+    static Follow ret;
+    return ret;
+}
+
 struct Linereader {
 
-    std::istream& infile;
+    std::istream* infile;
+    std::ifstream file;
+    MappedFile mapped;
+
+    std::unique_ptr<char[]> bufb;
+    const char* bufe;
+    const char* bufi;
+
+    // Gzip-compressed input is detected by its magic bytes and decompressed on the fly.
+    std::unique_ptr<Inflater> gz;
+    bool started;
+
+#ifdef _REENTRANT
+    std::unique_ptr<ReadAhead> readahead;
+#endif
+
+    std::string sep;
+    size_t recsize;
+    bool csv;
+    std::string scratch;
+    std::string csvpart;
+
+    // In follow mode the end of the file is not the end of the input.
+    bool following;
+    std::string fname;
+    ino_t inode;
+    size_t consumed;
+
+    static const size_t BUFSIZE = 64*1024;
+
+    Linereader(std::istream& i) : infile(&i), bufb(new char[BUFSIZE]), started(false), sep(record_separator()), recsize(record_size()), csv(csv_records()),
+                                  following(false), inode(0), consumed(0) {
+        bufe = bufb.get();
+        bufi = bufe;
+    }
+
+    // Regular files are memory-mapped and lines are read straight from the mapping;
+    // anything else (pipes, devices) and followed files go through the buffered stream path.
+    Linereader(const std::string& fn, bool follow = false) : infile(nullptr), started(true), sep(record_separator()), recsize(record_size()), csv(csv_records()),
+                                                             following(follow), fname(fn), inode(0), consumed(0) {
 
-    char bufb[64*1024];
-    char* bufe;
-    char* bufi;
-    char* bufi_p;
+        if (!following && mapped.open(fname)) {
+            bufe = mapped.data + mapped.size;
+            bufi = mapped.data;
 
-    Linereader(std::istream& i) :
-        infile(i), bufe(bufb + sizeof(bufb)), bufi(bufe), bufi_p(bufi)
-        {}
+            if (is_gzip(bufi, bufe)) {
+                gz.reset(new Inflater(bufi, bufe));
+                bufi = bufe;
+            }
+
+            return;
+        }
+
+        file.open(fname);
+
+        if (!file)
+            throw std::runtime_error("Could not open input file: " + fname);
+
+        infile = &file;
+        bufb.reset(new char[BUFSIZE]);
+        bufe = bufb.get();
+        bufi = bufe;
+        started = false;
+
+        struct stat st;
+
+        if (::stat(fname.c_str(), &st) == 0) {
+            inode = st.st_ino;
+        }
+    }
+
+    // Reads lines from a region of memory, e.g. a slice of a mapped file.
+    Linereader(const char* b, const char* e) : infile(nullptr), bufe(e), bufi(b), started(true), sep(record_separator()), recsize(record_size()), csv(csv_records()),
+                                               following(false), inode(0), consumed(0) {}
+
+    // Waits for a followed file to grow. A file that was truncated or replaced
+    // (e.g. by log rotation) is read again from the start.
+    void wait_for_data() {
+
+        follow().idle();
+
+        ::usleep(100000);
+
+        file.clear();
+
+        struct stat st;
+
+        if (::stat(fname.c_str(), &st) != 0)
+            return;
+
+        if (st.st_ino != inode || (size_t)st.st_size < consumed) {
+
+            file.close();
+            file.open(fname);
+            inode = st.st_ino;
+            consumed = 0;
+        }
+    }
+
+    // Reads the next block of raw bytes from the stream.
+    bool fetch(const char*& b, const char*& e) {
+
+        // A memory-mapped file is one big buffer; there is nothing more to read.
+        if (!infile)
+            return false;
+
+#ifdef _REENTRANT
+        if (readahead) {
+            auto blk = readahead->next();
+            b = blk.first;
+            e = blk.first + blk.second;
+            return (b != e);
+        }
+#endif
+
+        char* buf = bufb.get();
+
+        while (1) {
+
+            infile->read(buf, BUFSIZE);
+            b = buf;
+            e = buf + infile->gcount();
+            consumed += (e - b);
+
+            if (b != e || !following)
+                break;
+
+            wait_for_data();
+        }
+
+        return (b != e);
+    }
 
     void populate() {
 
-        infile.read(bufb, bufe - bufb);
-        bufi = bufb;
-        bufi_p = bufi;
+        if (gz) {
+            gz->next(bufi, bufe);
+            return;
+        }
+
+        fetch(bufi, bufe);
 
-        if (!infile) {
-            bufe = bufb + infile.gcount();
+        if (!started) {
+            started = true;
+
+            if (is_gzip(bufi, bufe)) {
+                gz.reset(new Inflater(bufi, bufe, [this](const char*& b, const char*& e) { return fetch(b, e); }));
+                gz->next(bufi, bufe);
+            }
         }
     }
     
-    bool getline(std::string& s) {
-        
+    // Switches a stream (but not a memory-mapped file) to reading in a background thread.
+    void start_readahead() {
+#ifdef _REENTRANT
+        if (infile && !following && !readahead && bufi == bufe) {
+            readahead.reset(new ReadAhead(*infile));
+        }
+#endif
+    }
+
+    // A multi-byte separator can straddle the end of the previous block: if it does,
+    // strip its head from the end of 's' and skip its tail in the buffer.
+    bool straddles(std::string& s) {
+
+        size_t m = sep.size();
+        size_t avail = bufe - bufi;
+
+        for (size_t j = std::min(m - 1, s.size()); j > 0; --j) {
+
+            if (avail >= m - j &&
+                s.compare(s.size() - j, j, sep, 0, j) == 0 &&
+                ::memcmp(bufi, sep.data() + j, m - j) == 0) {
+
+                s.resize(s.size() - j);
+                bufi += m - j;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Reads exactly n bytes; false if the input ends first, with whatever was read left in s.
+    bool getbytes(std::string& s, size_t n) {
+
         s.clear();
 
+        while (s.size() < n) {
+
+            if (bufi == bufe) {
+                populate();
+
+                if (bufi == bufe)
+                    return false;
+            }
+
+            size_t m = std::min(n - s.size(), (size_t)(bufe - bufi));
+            s.append(bufi, m);
+            bufi += m;
+        }
+
+        return true;
+    }
+
+    // Reads one byte, or returns -1 at the end of the input.
+    int getbyte() {
+
         if (bufi == bufe) {
             populate();
+
+            if (bufi == bufe)
+                return -1;
         }
 
-        if (bufi == bufe) {
+        return (unsigned char)*bufi++;
+    }
+
+    // Reads exactly one fixed-width binary record.
+    bool getrecord(std::string& s) {
+
+        if (getbytes(s, recsize))
+            return true;
+
+        if (s.empty())
             return false;
+
+        throw std::runtime_error("Truncated binary record at the end of the input.");
+    }
+
+    // Skips a record without copying it, unless it crosses a block boundary.
+    bool skipline() {
+
+        if (recsize && (size_t)(bufe - bufi) >= recsize) {
+            bufi += recsize;
+            return true;
         }
-        
+
+        if (!recsize && !csv && bufi != bufe) {
+
+            const char* x = find_separator(bufi, bufe, sep);
+
+            if (x) {
+                bufi = x + sep.size();
+                return true;
+            }
+        }
+
+        return getline(scratch);
+    }
+
+    bool getline(std::string& s) {
+
+        if (recsize)
+            return getrecord(s);
+
+        if (csv)
+            return getcsvrecord(s);
+
+        return getrawline(s);
+    }
+
+    static bool odd_quotes(const char* b, const char* e) {
+        return (std::count(b, e, '"') & 1);
+    }
+
+    // Reads a CSV record: a separator inside a quoted field does not end the record.
+    bool getcsvrecord(std::string& s) {
+
+        if (!getrawline(s))
+            return false;
+
+        bool quoted = odd_quotes(s.data(), s.data() + s.size());
+
+        while (quoted && getrawline(csvpart)) {
+            s += sep;
+            s += csvpart;
+            quoted = (quoted != odd_quotes(csvpart.data(), csvpart.data() + csvpart.size()));
+        }
+
+        return true;
+    }
+
+    bool getrawline(std::string& s) {
+
+        s.clear();
+
         while (1) {
 
-            if (*bufi == '\n') {
-                s.append(bufi_p, bufi);
-                ++bufi;
-                bufi_p = bufi;
+            if (bufi == bufe) {
+                populate();
+
+                if (bufi == bufe) {
+                    return !(s.empty());
+                }
+
+                if (sep.size() > 1 && !s.empty() && straddles(s)) {
+                    return true;
+                }
+            }
+
+            const char* x = find_separator(bufi, bufe, sep);
+
+            if (x) {
+                s.append(bufi, x);
+                bufi = x + sep.size();
                 return true;
             }
 
-            ++bufi;
+            // The line continues into the next block.
+            s.append(bufi, bufe);
+            bufi = bufe;
+        }
+    }
+
+    // Reads a block of whole lines: at least n bytes, unless the input ends first.
+    bool getblock(std::string& s, size_t n) {
+
+        s.clear();
+
+        if (recsize) {
+            n = (n + recsize - 1) / recsize * recsize;
+
+            while (s.size() < n) {
+
+                if (bufi == bufe) {
+                    populate();
+
+                    if (bufi == bufe)
+                        break;
+                }
+
+                size_t m = std::min(n - s.size(), (size_t)(bufe - bufi));
+                s.append(bufi, m);
+                bufi += m;
+            }
+
+            return !(s.empty());
+        }
+
+        while (1) {
 
             if (bufi == bufe) {
-                s.append(bufi_p, bufi);
                 populate();
 
                 if (bufi == bufe) {
                     return !(s.empty());
                 }
             }
+
+            size_t old = s.size();
+
+            s.append(bufi, bufe);
+            bufi = bufe;
+
+            if (s.size() < n)
+                continue;
+
+            // Look for the first separator that ends past the n-byte mark; it is
+            // always in the last appended block, which is still in the buffer.
+            size_t from = std::max(old, n);
+            from = (from >= sep.size() - 1 ? from - (sep.size() - 1) : 0);
+
+            const char* x = find_separator(s.data() + from, s.data() + s.size(), sep);
+
+            // A block of CSV records cannot end inside a quoted field.
+            if (csv) {
+
+                bool quoted = (x && odd_quotes(s.data(), x));
+
+                while (x && quoted) {
+
+                    const char* y = find_separator(x + sep.size(), s.data() + s.size(), sep);
+                    quoted = (quoted != odd_quotes(x, y ? y : s.data() + s.size()));
+                    x = y;
+                }
+            }
+
+            if (x) {
+                size_t cut = (x - s.data()) + sep.size();
+                bufi = bufe - (s.size() - cut);
+                s.resize(cut);
+                return true;
+            }
         }
+    }
+};
 
+// The name of the input file currently being read by this thread.
+std::string& current_filename() {
+    static thread_local std::string ret;
+    return ret;
+}
+
+// Identifies one version of a file, so that the files built from it ('--build-index',
+// '--cache') are not used once it changes: its device, inode and size, and its
+// modification and status change times to the nanosecond. Whole seconds are not enough
+// for a file rewritten right after the index was built, and the status change time also
+// catches a rewrite that puts the old modification time back.
+struct FileStamp {
+
+    static const size_t SIZE = 7;
+
+    UInt v[SIZE];
+
+    bool read(int fd) {
+
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0)
+            return false;
+
+        set(st);
+        return true;
+    }
+
+    bool read(const std::string& fname) {
+
+        struct stat st;
+
+        if (::stat(fname.c_str(), &st) != 0)
+            return false;
+
+        set(st);
         return true;
     }
+
+    void set(const struct stat& st) {
+
+        v[0] = st.st_dev;
+        v[1] = st.st_ino;
+        v[2] = st.st_size;
+        v[3] = st.st_mtim.tv_sec;
+        v[4] = st.st_mtim.tv_nsec;
+        v[5] = st.st_ctim.tv_sec;
+        v[6] = st.st_ctim.tv_nsec;
+    }
+
+    bool operator==(const FileStamp& s) const {
+        return std::equal(v, v + SIZE, s.v);
+    }
+
+    bool operator!=(const FileStamp& s) const {
+        return !(*this == s);
+    }
 };
 
+// A sidecar index of line offsets, 'FILE.tabidx', written by 'tab --build-index FILE'.
+// It stores the byte offset of every INTERVAL-th line, so that a reader can seek
+// straight to any line. The index is ignored if the file changed after it was built.
+struct LineIndex {
+
+    static const UInt INTERVAL = 1024;
+
+    UInt interval;
+    UInt nlines;
+    std::vector<UInt> offsets;
+
+    LineIndex() : interval(INTERVAL), nlines(0) {}
+
+    static std::string path(const std::string& fname) {
+        return fname + ".tabidx";
+    }
+
+    static std::string magic() {
+        return std::string("TABIDX2\0", 8);
+    }
+
+    void build(const MappedFile& f, const std::string& sep) {
+
+        const char* b = f.data;
+        const char* e = f.data + f.size;
+
+        offsets.clear();
+        nlines = 0;
+
+        while (b != e) {
+
+            if (nlines % interval == 0) {
+                offsets.push_back(b - f.data);
+            }
+
+            ++nlines;
+
+            const char* x = find_separator(b, e, sep);
+            b = (x ? x + sep.size() : e);
+        }
+    }
+
+    // The file format: magic, then the stamp of the indexed file, interval, number of
+    // lines, number of offsets and separator length as 64-bit words, then the separator
+    // and the offsets.
+    void save(const MappedFile& f, const std::string& sep, const std::string& fname) const {
+
+        FileStamp st;
+        UInt head[4] = { interval, nlines, offsets.size(), sep.size() };
+
+        if (!st.read(f.fd))
+            throw std::runtime_error("Could not write index file: " + fname);
+
+        std::ofstream out(fname, std::ios::binary | std::ios::trunc);
+
+        out.write(magic().data(), magic().size());
+        out.write((const char*)st.v, sizeof(st.v));
+        out.write((const char*)head, sizeof(head));
+        out.write(sep.data(), sep.size());
+        out.write((const char*)offsets.data(), offsets.size() * sizeof(UInt));
+
+        if (!out)
+            throw std::runtime_error("Could not write index file: " + fname);
+    }
+
+    bool load(const MappedFile& f, const std::string& sep, const std::string& fname) {
+
+        std::ifstream in(fname, std::ios::binary);
+
+        if (!in)
+            return false;
+
+        std::string m(magic().size(), '\0');
+        FileStamp saved;
+        FileStamp st;
+        UInt head[4];
+
+        if (!st.read(f.fd))
+            return false;
+
+        in.read(&m[0], m.size());
+        in.read((char*)saved.v, sizeof(saved.v));
+        in.read((char*)head, sizeof(head));
+
+        if (!in || m != magic() || saved != st || head[0] == 0 || head[3] != sep.size())
+            return false;
+
+        std::string s(sep.size(), '\0');
+        in.read(&s[0], s.size());
+
+        if (!in || s != sep)
+            return false;
+
+        interval = head[0];
+        nlines = head[1];
+        offsets.resize(head[2]);
+        in.read((char*)offsets.data(), offsets.size() * sizeof(UInt));
+
+        return (bool)in;
+    }
+};
+
+void build_index(const std::string& fname) {
+
+    MappedFile f;
+
+    if (!f.open(fname) || is_gzip(f.data, f.data + f.size))
+        throw std::runtime_error("Can only index a regular, non-empty, uncompressed file: " + fname);
+
+    if (csv_records())
+        throw std::runtime_error("Cannot index CSV records ('-R csv').");
+
+    LineIndex index;
+    index.build(f, record_separator());
+    index.save(f, record_separator(), LineIndex::path(fname));
+}
+
 struct SeqFile : public obj::SeqBase {
 
     obj::String* holder;
     Linereader reader;
-    
-    SeqFile(std::istream& infile) : reader(infile) {
+    std::string name;
+    bool named;
+
+    // Lines read so far, and the line offset index, if the file has one.
+    UInt lineno;
+    std::unique_ptr<LineIndex> index;
+
+    SeqFile(std::istream& infile) : reader(infile), named(false), lineno(0) {
+        holder = new obj::String;
+    }
+
+    SeqFile(const std::string& fname) : reader(fname, follow().enabled), name(fname), named(false), lineno(0) {
+        holder = new obj::String;
+
+        if (reader.mapped.data && !reader.gz && !reader.recsize && !reader.csv) {
+            index.reset(new LineIndex);
+
+            if (!index->load(reader.mapped, reader.sep, LineIndex::path(fname)))
+                index.reset();
+        }
+    }
+
+    SeqFile(const char* b, const char* e, const std::string& fname) : reader(b, e), name(fname), named(false), lineno(0) {
         holder = new obj::String;
     }
 
@@ -76,19 +862,253 @@ struct SeqFile : public obj::SeqBase {
     }
 
     obj::Object* next() {
+
+        if (!named) {
+            current_filename() = name;
+            named = true;
+
+        } else if (reader.following) {
+            // The previous record has been fully processed by now.
+            follow().tick();
+        }
+
         bool ok = reader.getline(holder->v);
 
         if (!ok) return nullptr;
 
+        ++lineno;
+
         return holder;
     }
+
+    UInt skip(UInt n) {
+
+        const char* data = reader.mapped.data;
+        UInt target = lineno + n;
+
+        if (data && !reader.gz && reader.recsize) {
+
+            // Fixed-width records in a mapped file: seek straight to the target.
+            UInt left = (reader.bufe - reader.bufi) / reader.recsize;
+            UInt k = std::min(n, left);
+            reader.bufi += k * reader.recsize;
+            lineno += k;
+            return k;
+        }
+
+        if (index) {
+            UInt k = target / index->interval;
+
+            if (k < index->offsets.size() && k * index->interval > lineno) {
+                reader.bufi = data + index->offsets[k];
+                lineno = k * index->interval;
+            }
+        }
+
+        while (lineno < target && reader.skipline()) {
+            ++lineno;
+        }
+
+        return n - (target - lineno);
+    }
+};
+
+// Sampling, set with the '-S' or '--sample-bytes' command-line options: only the lines
+// at random offsets of the input file are read; the rest of the file is never touched.
+struct Sampling {
+
+    size_t lines;
+    double fraction;
+    size_t seed;
+
+    static const size_t BLOCKSIZE = 64*1024;
+
+    Sampling() : lines(0), fraction(0), seed(0) {}
+
+    bool enabled() const {
+        return (lines > 0 || fraction > 0);
+    }
+
+    // Sorted byte offsets: one per sampled line, or the start of each sampled block.
+    std::vector<size_t> offsets(size_t size) const {
+
+        std::vector<size_t> ret;
+        std::mt19937_64 gen(seed);
+
+        if (size == 0)
+            return ret;
+
+        if (lines > 0) {
+            std::uniform_int_distribution<size_t> d(0, size - 1);
+
+            for (size_t i = 0; i < lines; ++i) {
+                ret.push_back(d(gen));
+            }
+
+            std::sort(ret.begin(), ret.end());
+
+        } else {
+            // Every block is picked with the given probability; the gaps between
+            // picked blocks are geometrically distributed.
+            std::geometric_distribution<size_t> d(std::min(fraction, 1.0));
+
+            for (size_t b = d(gen); b * BLOCKSIZE < size; b += 1 + d(gen)) {
+                ret.push_back(b * BLOCKSIZE);
+            }
+        }
+
+        return ret;
+    }
+};
+
+Sampling& sampling() {
+    static Sampling ret;
+    return ret;
+}
+
+struct SeqSample : public obj::SeqBase {
+
+    std::shared_ptr<MappedFile> mapped;
+    std::vector<size_t> offsets;
+    size_t blocksize;
+    size_t oi;
+    Linereader reader;
+    const char* stop;
+    obj::String holder;
+    std::string name;
+    bool named;
+
+    // With a zero blocksize the line that follows every offset is read, otherwise all
+    // the lines that start within 'blocksize' bytes of it.
+    SeqSample(std::shared_ptr<MappedFile> m, std::vector<size_t>&& o, size_t bs, const std::string& fname) :
+        mapped(m), offsets(o), blocksize(bs), oi(0),
+        reader(m->data, m->data), stop(m->data), name(fname), named(false) {}
+
+    // Resynchronizes to the first record that starts at or after 'off'.
+    const char* record_start(size_t off) {
+
+        const char* data = mapped->data;
+        const char* end = data + mapped->size;
+
+        if (reader.recsize) {
+            off = (off + reader.recsize - 1) / reader.recsize * reader.recsize;
+            return std::min(data + off, end);
+        }
+
+        size_t m = reader.sep.size();
+
+        if (off == 0)
+            return data;
+
+        const char* x = find_separator(data + (off >= m ? off - m : 0), end, reader.sep);
+        return (x ? x + m : end);
+    }
+
+    obj::Object* next() {
+
+        if (!named) {
+            current_filename() = name;
+            named = true;
+        }
+
+        while (1) {
+
+            if (reader.bufi < stop && reader.getline(holder.v))
+                return &holder;
+
+            if (oi >= offsets.size())
+                return nullptr;
+
+            size_t off = offsets[oi];
+            ++oi;
+
+            const char* b = record_start(off);
+
+            // Lines are sampled with replacement; the last line wraps around to the first.
+            // Overlapping blocks are not read twice.
+            if (!blocksize && b == mapped->data + mapped->size) {
+                b = mapped->data;
+
+            } else if (blocksize && b < reader.bufi) {
+                b = reader.bufi;
+            }
+
+            reader.bufi = b;
+            reader.bufe = mapped->data + mapped->size;
+            stop = (blocksize ? mapped->data + off + blocksize : b + 1);
+        }
+    }
+
+    // Opens a file for sampling and splits the sampled offsets into 'n' parts.
+    static std::vector<obj::Object*> open(const std::string& fname, size_t n) {
+
+        const Sampling& smp = sampling();
+        std::shared_ptr<MappedFile> m = std::make_shared<MappedFile>();
+
+        if (!m->open(fname) || is_gzip(m->data, m->data + m->size))
+            throw std::runtime_error("Sampling needs a regular, uncompressed input file: " + fname);
+
+        std::vector<size_t> offs = smp.offsets(m->size);
+        size_t bs = (smp.lines > 0 ? 0 : Sampling::BLOCKSIZE);
+
+        std::vector<obj::Object*> ret;
+
+        for (size_t i = 0; i < n; ++i) {
+            std::vector<size_t> part(offs.begin() + (offs.size() * i) / n, offs.begin() + (offs.size() * (i + 1)) / n);
+            ret.push_back(new SeqSample(m, std::move(part), bs, fname));
+        }
+
+        return ret;
+    }
+};
+
+// Reads several input files one after another.
+struct SeqFiles : public obj::SeqBase {
+
+    obj::String* holder;
+    std::unique_ptr<Linereader> reader;
+    std::vector<std::string> files;
+    size_t filei;
+
+    SeqFiles(const std::vector<std::string>& f = std::vector<std::string>()) : files(f), filei(0) {
+        holder = new obj::String;
+    }
+
+    ~SeqFiles() {
+        delete holder;
+    }
+
+    virtual bool next_file(std::string& fname) {
+
+        if (filei >= files.size())
+            return false;
+
+        fname = files[filei];
+        ++filei;
+        return true;
+    }
+
+    obj::Object* next() {
+
+        while (1) {
+
+            if (reader && reader->getline(holder->v))
+                return holder;
+
+            std::string& fname = current_filename();
+
+            if (!next_file(fname))
+                return nullptr;
+
+            reader.reset(new Linereader(fname));
+        }
+    }
 };
 
 struct SeqFileV : public obj::SeqBase {
 
     obj::String* holder;
     Linereader* reader;
-    std::ifstream file;
 
     SeqFileV() {
         holder = new obj::String;
@@ -102,18 +1122,14 @@ struct SeqFileV : public obj::SeqBase {
 
     void open(const std::string& fname) {
 
-        if (file.is_open())
-            file.close();
-
-        file.open(fname);
-
-        if (!file)
-            throw std::runtime_error("Could not open input file: " + fname);
-
         if (reader)
             delete reader;
 
-        reader = new Linereader(file);
+        reader = nullptr;
+        reader = new Linereader(fname);
+
+        // Binary records are for the main input only; files opened here are text.
+        reader->recsize = 0;
     }
 
     obj::Object* next() {
@@ -147,10 +1163,15 @@ Functions::func_t file_checker(const Type& args, Type& ret, obj::Object*& obj) {
     return file;
 }
 
+void filename(const obj::Object* in, obj::Object*& out) {
+    obj::get<obj::String>(out).v = current_filename();
+}
+
 void register_file(Functions& funcs) {
 
     funcs.add_poly("file", file_checker);
     funcs.add_poly("open", file_checker);
+    funcs.add("filename", Type(), Type(Type::STRING), filename);
 }
 
 #endif
@@ -55,12 +55,10 @@ struct SeqSkipSeq : public obj::SeqBase {
     
     obj::Object* next() {
 
-        while (i < n) {
-            obj::Object* ret = seq->next();
+        if (i < n) {
+            i += seq->skip(n - i);
 
-            if (!ret) return ret;
-        
-            ++i;
+            if (i < n) return nullptr;
         }
 
         return seq->next();
@@ -97,16 +95,12 @@ struct SeqStripeSeq : public obj::SeqBase {
     
     obj::Object* next() {
 
-        obj::Object* ret = seq->next();
-        ++i;
-
-        while (ret && ((i - 1) % n) != 0) {
-
-            ret = seq->next();
-            ++i;
+        if (i > 0 && n > 1) {
+            seq->skip(n - 1);
         }
 
-        return ret;
+        ++i;
+        return seq->next();
     }
 };
 
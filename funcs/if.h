@@ -291,6 +291,9 @@ void register_if(Functions& funcs) {
     funcs.add_poly("eq", eq_checker);
     funcs.add_poly("and", and_or_checker<true>);
     funcs.add_poly("or", and_or_checker<false>);
+
+    // The other arguments are compared with a virtual call on the first, so only it can be a view.
+    funcs.add_view_taker(eqfun, 0, eqfun);
 }
 
 #endif
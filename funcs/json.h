@@ -0,0 +1,546 @@
+#ifndef __TAB_FUNCS_JSON_H
+#define __TAB_FUNCS_JSON_H
+
+// Extracts values from a JSON document by path, e.g. 'a.b[2].c', without parsing the
+// whole document: the scanner walks only down the path, and every value that is not
+// on the path is skipped by matching brackets and quotes.
+
+struct JsonPath {
+
+    struct step_t {
+        bool index;
+        std::string key;
+        UInt n;
+    };
+
+    std::string src;
+    std::vector<step_t> steps;
+    bool compiled;
+
+    JsonPath() : compiled(false) {}
+
+    // Compiles the path once; calls with the same path string (e.g. a literal) reuse it.
+    void compile(const std::string& path) {
+
+        if (compiled && path == src)
+            return;
+
+        src = path;
+        steps.clear();
+
+        size_t i = 0;
+
+        while (i < path.size()) {
+
+            if (path[i] == '.') {
+                ++i;
+                continue;
+            }
+
+            step_t s = { false, "", 0 };
+
+            if (path[i] == '[') {
+
+                size_t j = path.find(']', i);
+
+                if (j == std::string::npos || j == i + 1 || path.find_first_not_of("0123456789", i + 1) != j)
+                    throw std::runtime_error("Invalid array index in JSON path: '" + path + "'");
+
+                s.index = true;
+                s.n = std::stoul(path.substr(i + 1, j - i - 1));
+                i = j + 1;
+
+            } else {
+
+                size_t j = path.find_first_of(".[", i);
+
+                if (j == std::string::npos)
+                    j = path.size();
+
+                s.key = path.substr(i, j - i);
+                i = j;
+            }
+
+            steps.push_back(s);
+        }
+
+        compiled = true;
+    }
+};
+
+namespace json {
+
+inline const char* skip_ws(const char* p, const char* e) {
+
+    while (p != e && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        ++p;
+
+    return p;
+}
+
+// 'p' points past the opening quote; returns a pointer to the closing quote.
+inline const char* string_end(const char* p, const char* e) {
+
+    while (1) {
+
+        const char* q = (const char*)::memchr(p, '"', e - p);
+
+        if (!q)
+            return nullptr;
+
+        // The quote is escaped if it follows an odd number of backslashes.
+        const char* b = q;
+
+        while (b != p && b[-1] == '\\')
+            --b;
+
+        if (((q - b) & 1) == 0)
+            return q;
+
+        p = q + 1;
+    }
+}
+
+// Returns a pointer past the end of the value at 'p', or nullptr if it is malformed.
+inline const char* skip_value(const char* p, const char* e) {
+
+    if (p == e)
+        return nullptr;
+
+    if (*p == '"') {
+        const char* q = string_end(p + 1, e);
+        return (q ? q + 1 : nullptr);
+    }
+
+    if (*p == '{' || *p == '[') {
+
+        size_t depth = 0;
+
+        while (p != e) {
+
+            switch (*p) {
+            case '"':
+                p = string_end(p + 1, e);
+
+                if (!p)
+                    return nullptr;
+                break;
+
+            case '{':
+            case '[':
+                ++depth;
+                break;
+
+            case '}':
+            case ']':
+                if (--depth == 0)
+                    return p + 1;
+                break;
+            }
+
+            ++p;
+        }
+
+        return nullptr;
+    }
+
+    // Numbers, true, false and null.
+    while (p != e && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+        ++p;
+
+    return p;
+}
+
+inline void put_utf8(unsigned long c, std::string& out) {
+
+    if (c < 0x80) {
+        out += (char)c;
+
+    } else if (c < 0x800) {
+        out += (char)(0xC0 | (c >> 6));
+        out += (char)(0x80 | (c & 0x3F));
+
+    } else if (c < 0x10000) {
+        out += (char)(0xE0 | (c >> 12));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+
+    } else {
+        out += (char)(0xF0 | (c >> 18));
+        out += (char)(0x80 | ((c >> 12) & 0x3F));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+    }
+}
+
+inline bool hex4(const char* p, const char* e, unsigned long& out) {
+
+    if (e - p < 4)
+        return false;
+
+    out = 0;
+
+    for (int i = 0; i < 4; ++i) {
+
+        char c = p[i];
+        out <<= 4;
+
+        if (c >= '0' && c <= '9') out |= c - '0';
+        else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+        else return false;
+    }
+
+    return true;
+}
+
+// Decodes the escapes of the string contents between 'b' and 'e'.
+inline void unescape(const char* b, const char* e, std::string& out) {
+
+    out.clear();
+
+    while (b != e) {
+
+        const char* x = (const char*)::memchr(b, '\\', e - b);
+
+        if (!x) {
+            out.append(b, e);
+            return;
+        }
+
+        out.append(b, x);
+        b = x + 1;
+
+        if (b == e)
+            return;
+
+        char c = *b++;
+
+        switch (c) {
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            unsigned long u;
+
+            if (!hex4(b, e, u)) {
+                out += "\\u";
+                break;
+            }
+
+            b += 4;
+
+            // A surrogate pair.
+            unsigned long lo;
+
+            if (u >= 0xD800 && u < 0xDC00 && e - b >= 6 && b[0] == '\\' && b[1] == 'u' &&
+                hex4(b + 2, e, lo) && lo >= 0xDC00 && lo < 0xE000) {
+
+                u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+                b += 6;
+            }
+
+            put_utf8(u, out);
+            break;
+        }
+        default:
+            out += c;
+        }
+    }
+}
+
+// Compares a raw (possibly escaped) object key with a path step.
+inline bool key_equals(const char* b, const char* e, const std::string& key, std::string& scratch) {
+
+    if (::memchr(b, '\\', e - b) == nullptr)
+        return ((size_t)(e - b) == key.size() && ::memcmp(b, key.data(), key.size()) == 0);
+
+    unescape(b, e, scratch);
+    return (scratch == key);
+}
+
+// Finds the value at the path; returns false if the path does not exist.
+inline bool find(const char* p, const char* e, const JsonPath& path, const char*& vb, const char*& ve, std::string& scratch) {
+
+    p = skip_ws(p, e);
+
+    for (const JsonPath::step_t& s : path.steps) {
+
+        if (p == e)
+            return false;
+
+        if (s.index) {
+
+            if (*p != '[')
+                return false;
+
+            p = skip_ws(p + 1, e);
+
+            if (p != e && *p == ']')
+                return false;
+
+            for (UInt i = 0; i < s.n; ++i) {
+
+                p = skip_value(p, e);
+
+                if (!p)
+                    return false;
+
+                p = skip_ws(p, e);
+
+                if (p == e || *p != ',')
+                    return false;
+
+                p = skip_ws(p + 1, e);
+            }
+
+        } else {
+
+            if (*p != '{')
+                return false;
+
+            p = skip_ws(p + 1, e);
+
+            while (1) {
+
+                if (p == e || *p != '"')
+                    return false;
+
+                const char* kb = p + 1;
+                const char* ke = string_end(kb, e);
+
+                if (!ke)
+                    return false;
+
+                p = skip_ws(ke + 1, e);
+
+                if (p == e || *p != ':')
+                    return false;
+
+                p = skip_ws(p + 1, e);
+
+                if (key_equals(kb, ke, s.key, scratch))
+                    break;
+
+                p = skip_value(p, e);
+
+                if (!p)
+                    return false;
+
+                p = skip_ws(p, e);
+
+                if (p == e || *p != ',')
+                    return false;
+
+                p = skip_ws(p + 1, e);
+            }
+        }
+    }
+
+    const char* x = skip_value(p, e);
+
+    if (!x || x == p)
+        return false;
+
+    vb = p;
+    ve = x;
+    return true;
+}
+
+// Strings are unescaped; anything else is returned as its JSON text.
+inline bool get(const std::string& doc, const JsonPath& path, std::string& out, std::string& scratch) {
+
+    const char* vb;
+    const char* ve;
+
+    if (!find(doc.data(), doc.data() + doc.size(), path, vb, ve, scratch))
+        return false;
+
+    if (*vb == '"') {
+        unescape(vb + 1, ve - 1, out);
+    } else {
+        out.assign(vb, ve);
+    }
+
+    return true;
+}
+
+inline bool to_number(const std::string& s, Int& out) {
+    return parse_int(s.data(), s.data() + s.size(), out);
+}
+
+inline bool to_number(const std::string& s, UInt& out) {
+    return parse_uint(s.data(), s.data() + s.size(), out);
+}
+
+inline bool to_number(const std::string& s, Real& out) {
+    return parse_real(s.data(), s.data() + s.size(), out);
+}
+
+} // namespace json
+
+// The result objects keep the compiled paths of their FUN command.
+
+struct JsonString : public obj::String {
+    JsonPath path;
+    std::string scratch;
+};
+
+template <typename T>
+struct JsonNumber : public obj::Atom<T> {
+    JsonPath path;
+    std::string value;
+    std::string scratch;
+};
+
+struct JsonTuple : public obj::Tuple {
+
+    std::vector<JsonPath> paths;
+    std::string scratch;
+
+    JsonTuple(size_t n) : paths(n) {
+
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back(new obj::String);
+        }
+    }
+};
+
+// With LITERAL, the paths were compiled when the program was type-checked.
+
+template <bool LITERAL>
+void json_string(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+    JsonString& ret = obj::get<JsonString>(out);
+
+    if (!LITERAL)
+        ret.path.compile(obj::get<obj::String>(args.v[1]).v);
+
+    if (!json::get(obj::get<obj::String>(args.v[0]).v, ret.path, ret.v, ret.scratch))
+        throw std::runtime_error("Path not found in 'json': '" + ret.path.src + "'");
+}
+
+template <bool LITERAL, typename T>
+void json_number(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+    JsonNumber<T>& ret = obj::get< JsonNumber<T> >(out);
+
+    if (!LITERAL)
+        ret.path.compile(obj::get<obj::String>(args.v[1]).v);
+
+    if (!json::get(obj::get<obj::String>(args.v[0]).v, ret.path, ret.value, ret.scratch) ||
+        !json::to_number(ret.value, ret.v)) {
+
+        ret.v = obj::get< obj::Atom<T> >(args.v[2]).v;
+    }
+}
+
+template <bool LITERAL>
+void json_tuple(const obj::Object* in, obj::Object*& out) {
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+    JsonTuple& ret = obj::get<JsonTuple>(out);
+
+    const std::string& doc = obj::get<obj::String>(args.v[0]).v;
+
+    for (size_t i = 0; i < ret.paths.size(); ++i) {
+
+        if (!LITERAL)
+            ret.paths[i].compile(obj::get<obj::String>(args.v[i + 1]).v);
+
+        if (!json::get(doc, ret.paths[i], obj::get<obj::String>(ret.v[i]).v, ret.scratch))
+            throw std::runtime_error("Path not found in 'json': '" + ret.paths[i].src + "'");
+    }
+}
+
+template <typename T>
+Functions::func_t json_number_checker(const Type& path, obj::Object*& obj) {
+
+    JsonNumber<T>* ret = new JsonNumber<T>;
+    obj = ret;
+
+    const std::string* lit = literal_string(path);
+
+    if (!lit)
+        return json_number<false, T>;
+
+    ret->path.compile(*lit);
+    return json_number<true, T>;
+}
+
+Functions::func_t json_checker(const Type& args, Type& ret, obj::Object*& obj) {
+
+    if (args.type != Type::TUP || args.tuple->size() < 2)
+        return nullptr;
+
+    const std::vector<Type>& tup = *(args.tuple);
+
+    if (tup[0] != Type(Type::STRING) || tup[1] != Type(Type::STRING))
+        return nullptr;
+
+    if (tup.size() == 2) {
+
+        ret = Type(Type::STRING);
+
+        JsonString* js = new JsonString;
+        obj = js;
+
+        const std::string* lit = literal_string(tup[1]);
+
+        if (!lit)
+            return json_string<false>;
+
+        js->path.compile(*lit);
+        return json_string<true>;
+    }
+
+    if (tup.size() == 3 && tup[2].type == Type::ATOM && tup[2].atom != Type::STRING) {
+
+        ret = tup[2];
+
+        switch (tup[2].atom) {
+        case Type::INT:
+            return json_number_checker<Int>(tup[1], obj);
+        case Type::UINT:
+            return json_number_checker<UInt>(tup[1], obj);
+        default:
+            return json_number_checker<Real>(tup[1], obj);
+        }
+    }
+
+    ret = Type(Type::TUP);
+
+    bool literal = true;
+
+    for (size_t i = 1; i < tup.size(); ++i) {
+
+        if (tup[i] != Type(Type::STRING))
+            return nullptr;
+
+        ret.push(Type(Type::STRING));
+        literal = literal && literal_string(tup[i]);
+    }
+
+    JsonTuple* jt = new JsonTuple(tup.size() - 1);
+    obj = jt;
+
+    if (!literal)
+        return json_tuple<false>;
+
+    for (size_t i = 1; i < tup.size(); ++i) {
+        jt->paths[i - 1].compile(*literal_string(tup[i]));
+    }
+
+    return json_tuple<true>;
+}
+
+void register_json(Functions& funcs) {
+
+    funcs.add_poly("json", json_checker);
+}
+
+#endif
@@ -7,56 +7,50 @@ void x_to_y(const obj::Object* in, obj::Object*& out) {
 }
 
 void string_to_real(const obj::Object* in, obj::Object*& out) {
-    try {
-        obj::get<obj::Real>(out).v = std::stod(obj::get<obj::String>(in).v);
-    } catch (std::exception& e) {
-        throw std::runtime_error("Could not convert '" + obj::get<obj::String>(in).v + "' to a floating-point number.");
-    }
+    const std::string& s = obj::get<obj::String>(in).v;
+
+    if (!parse_real(s.data(), s.data() + s.size(), obj::get<obj::Real>(out).v))
+        throw std::runtime_error("Could not convert '" + s + "' to a floating-point number.");
 }
 
 void string_to_int(const obj::Object* in, obj::Object*& out) {
-    try {
-        obj::get<obj::Int>(out).v = std::stol(obj::get<obj::String>(in).v, 0, 0);
-    } catch (std::exception& e) {
-        throw std::runtime_error("Could not convert '" + obj::get<obj::String>(in).v + "' to an integer.");
-    }
+    const std::string& s = obj::get<obj::String>(in).v;
+
+    if (!parse_int(s.data(), s.data() + s.size(), obj::get<obj::Int>(out).v))
+        throw std::runtime_error("Could not convert '" + s + "' to an integer.");
 }
 
 void string_to_uint(const obj::Object* in, obj::Object*& out) {
-    try {
-        obj::get<obj::UInt>(out).v = std::stoul(obj::get<obj::String>(in).v, 0, 0);
-    } catch (std::exception& e) {
-        throw std::runtime_error("Could not convert '" + obj::get<obj::String>(in).v + "' to an unsigned integer.");
-    }
+    const std::string& s = obj::get<obj::String>(in).v;
+
+    if (!parse_uint(s.data(), s.data() + s.size(), obj::get<obj::UInt>(out).v))
+        throw std::runtime_error("Could not convert '" + s + "' to an unsigned integer.");
 }
 
 void string_to_real_def(const obj::Object* in, obj::Object*& out) {
     obj::Tuple& arg = obj::get<obj::Tuple>(in);
-    try {
-        obj::get<obj::Real>(out).v = std::stod(obj::get<obj::String>(arg.v[0]).v);
-    } catch (std::exception& e) {
+    const std::string& s = obj::get<obj::String>(arg.v[0]).v;
+
+    if (!parse_real(s.data(), s.data() + s.size(), obj::get<obj::Real>(out).v))
         obj::get<obj::Real>(out).v = obj::get<obj::Real>(arg.v[1]).v;
-    }
 }
 
 template <typename T>
 void string_to_int_def(const obj::Object* in, obj::Object*& out) {
     obj::Tuple& arg = obj::get<obj::Tuple>(in);
-    try {
-        obj::get<obj::Int>(out).v = std::stol(obj::get<obj::String>(arg.v[0]).v, 0, 0);
-    } catch (std::exception& e) {
+    const std::string& s = obj::get<obj::String>(arg.v[0]).v;
+
+    if (!parse_int(s.data(), s.data() + s.size(), obj::get<obj::Int>(out).v))
         obj::get<obj::Int>(out).v = obj::get<T>(arg.v[1]).v;
-    }
 }
 
 template <typename T>
 void string_to_uint_def(const obj::Object* in, obj::Object*& out) {
     obj::Tuple& arg = obj::get<obj::Tuple>(in);
-    try {
-        obj::get<obj::UInt>(out).v = std::stoul(obj::get<obj::String>(arg.v[0]).v, 0, 0);
-    } catch (std::exception& e) {
+    const std::string& s = obj::get<obj::String>(arg.v[0]).v;
+
+    if (!parse_uint(s.data(), s.data() + s.size(), obj::get<obj::UInt>(out).v))
         obj::get<obj::UInt>(out).v = obj::get<T>(arg.v[1]).v;
-    }
 }
 
 template <typename T>
@@ -64,6 +58,18 @@ void to_string(const obj::Object* in, obj::Object*& out) {
     obj::get<obj::String>(out).v = std::to_string(obj::get<T>(in).v);
 }
 
+template <>
+void to_string<obj::UInt>(const obj::Object* in, obj::Object*& out) {
+    char tmp[NUMBER_SPACE];
+    obj::get<obj::String>(out).v.assign(tmp, format_uint(obj::get<obj::UInt>(in).v, tmp));
+}
+
+template <>
+void to_string<obj::Int>(const obj::Object* in, obj::Object*& out) {
+    char tmp[NUMBER_SPACE];
+    obj::get<obj::String>(out).v.assign(tmp, format_int(obj::get<obj::Int>(in).v, tmp));
+}
+
 void pi(const obj::Object* in, obj::Object*& out) {
     obj::get<obj::Real>(out).v = 3.141592653589793;
 }
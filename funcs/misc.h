@@ -319,6 +319,7 @@ void register_misc(Functions& funcs) {
               bytes_to_string);
 
     funcs.add_poly("hash", hash_checker);
+    funcs.add_view_taker(obj_hash, Functions::WHOLE_ARG, obj_hash);
     funcs.add_poly("cat", cat_checker);
     funcs.add_poly("tuple", tuple_checker);
     funcs.add_poly("lines", lines_checker);
@@ -55,63 +55,195 @@ void hex_decode(I& i, I e, std::string& out) {
     }
 }
 
-void url_getparam(const std::string& a, const std::string& param, std::string& out) {
+// A URL split once into its parts and its query-string parameters. The parameters are
+// found exactly like url_getparam() always has: keys start after '?' or '&', and the
+// scan stops at a space after a value. Values are percent-decoded when first asked for.
+struct UrlParts {
+
+    // The key and the undecoded value are offsets into 'url'.
+    struct param_t {
+        size_t key;
+        size_t keylen;
+        size_t pos;
+        bool decoded;
+        std::string value;
+    };
+
+    std::string url;
+    bool valid;
+    bool split_done;
+
+    std::string scheme;
+    std::string host;
+    std::string path;
+
+    // Only the first 'nparams' entries are in use; the rest keep their memory.
+    std::vector<param_t> params;
+    size_t nparams;
+
+    UrlParts() : valid(false), split_done(false), nparams(0) {}
+
+    param_t& add_param() {
+
+        if (nparams == params.size()) {
+            params.emplace_back();
+        }
 
-    enum {
-        KEY,
-        VAL,
-        MYVAL
-    } state = KEY;
+        param_t& ret = params[nparams];
+        ++nparams;
 
-    std::string key;
+        ret.decoded = false;
+        return ret;
+    }
 
-    auto i = a.begin();
-    auto e = a.end();
+    // Scheme, host and path are only split out when asked for.
+    void split() {
 
-    while (i != e) {
-        unsigned char c = *i;
+        if (split_done)
+            return;
 
-        if (state == KEY) {
+        split_done = true;
 
-            if (c == '=') {
+        const char* b = url.data();
+        const char* e = b + url.size();
+        const char* p = b;
 
-                if (key == param) {
-                    state = MYVAL;
-                } else {
-                    state = VAL;
-                }
+        scheme.clear();
+        host.clear();
 
-                key.clear();
+        const char* s = (const char*)::memmem(b, e - b, "://", 3);
 
-            } else if (c == '?') {
-                key.clear();
+        if (s && s != b && std::all_of(b, s, [](char c) {
+                    return (c == '+' || c == '-' || c == '.' || (c >= '0' && c <= '9') ||
+                            ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')); })) {
 
-            } else {
-                key += c;
-            }
+            scheme.assign(b, s);
+            p = s + 1;
+        }
 
-        } else if (state == MYVAL) {
+        if (e - p >= 2 && p[0] == '/' && p[1] == '/') {
 
-            if (c == '&' || c == ' ') {
-                return;
-            }
+            p += 2;
+            const char* h = p;
 
-            hex_decode(i, e, out);
+            while (p != e && *p != '/' && *p != '?' && *p != '#')
+                ++p;
 
-            if (i == e)
-                return;
+            host.assign(h, p);
+        }
+
+        const char* q = p;
+
+        while (q != e && *q != '?' && *q != '#')
+            ++q;
+
+        path.assign(p, q);
+    }
+
+    void scan_params(const std::string& a) {
+
+        nparams = 0;
+
+        bool in_key = true;
+        param_t* kv = &add_param();
+        kv->key = 0;
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            unsigned char c = a[i];
+
+            if (in_key) {
+
+                if (c == '=') {
+                    in_key = false;
+                    kv->keylen = i - kv->key;
+                    kv->pos = i + 1;
+
+                } else if (c == '?') {
+                    kv->key = i + 1;
+                }
 
-        } else {
+            } else if (c == '&') {
+                in_key = true;
+                kv = &add_param();
+                kv->key = i + 1;
 
-            if (c == '&') {
-                state = KEY;
             } else if (c == ' ') {
-                return;
+                break;
             }
         }
 
-        ++i;
+        // A trailing key without a value is not a parameter.
+        if (in_key) {
+            --nparams;
+        }
     }
+
+    // Like the scan, a value ends at '&' or a space; but a '%' escape is decoded first,
+    // even when it is broken and swallows the character after it.
+    void decode(param_t& kv) {
+
+        kv.value.clear();
+
+        auto i = url.cbegin() + kv.pos;
+        auto e = url.cend();
+
+        while (i != e && *i != '&' && *i != ' ') {
+
+            hex_decode(i, e, kv.value);
+
+            if (i == e)
+                break;
+
+            ++i;
+        }
+
+        kv.decoded = true;
+    }
+
+    void parse(const std::string& a) {
+
+        if (valid && a == url)
+            return;
+
+        url = a;
+        scan_params(a);
+        valid = true;
+        split_done = false;
+    }
+
+    const std::string& value(size_t i) {
+
+        param_t& kv = params[i];
+
+        if (!kv.decoded) {
+            decode(kv);
+        }
+
+        return kv.value;
+    }
+
+    const std::string* get(const std::string& key) {
+
+        for (size_t i = 0; i < nparams; ++i) {
+
+            const param_t& kv = params[i];
+
+            if (kv.keylen == key.size() && ::memcmp(url.data() + kv.key, key.data(), kv.keylen) == 0)
+                return &value(i);
+        }
+
+        return nullptr;
+    }
+};
+
+// The decomposition of the last URL seen by this thread, so that asking for several
+// parameters of the same URL scans it only once.
+UrlParts& url_parts(const std::string& url) {
+
+    static thread_local UrlParts parts;
+
+    parts.parse(url);
+    return parts;
 }
 
 void url_getparam(const obj::Object* in, obj::Object*& out) {
@@ -123,9 +255,79 @@ void url_getparam(const obj::Object* in, obj::Object*& out) {
 
     std::string& val = obj::get<obj::String>(out).v;
 
-    val.clear();
+    const std::string* v = url_parts(url).get(key);
 
-    url_getparam(url, key, val);
+    if (v) {
+        val.assign(*v);
+    } else {
+        val.clear();
+    }
+}
+
+// The result of url_parse: (scheme, host, path, Arr[(key, value)]).
+struct UrlParse : public obj::Tuple {
+
+    // Parameter tuples not in use by the current URL, kept for the next ones.
+    std::vector<obj::Object*> spare;
+
+    UrlParse() {
+        v.push_back(new obj::String);
+        v.push_back(new obj::String);
+        v.push_back(new obj::String);
+        v.push_back(new obj::ArrayObject);
+    }
+
+    ~UrlParse() {
+
+        for (obj::Object* x : spare) {
+            delete x;
+        }
+    }
+
+    void set(UrlParts& parts) {
+
+        parts.split();
+
+        obj::get<obj::String>(v[0]).v = parts.scheme;
+        obj::get<obj::String>(v[1]).v = parts.host;
+        obj::get<obj::String>(v[2]).v = parts.path;
+
+        std::vector<obj::Object*>& params = obj::get<obj::ArrayObject>(v[3]).v;
+
+        while (params.size() > parts.nparams) {
+            spare.push_back(params.back());
+            params.pop_back();
+        }
+
+        while (params.size() < parts.nparams) {
+
+            if (!spare.empty()) {
+                params.push_back(spare.back());
+                spare.pop_back();
+                continue;
+            }
+
+            obj::Tuple* kv = new obj::Tuple;
+            kv->v.push_back(new obj::String);
+            kv->v.push_back(new obj::String);
+            params.push_back(kv);
+        }
+
+        for (size_t i = 0; i < parts.nparams; ++i) {
+
+            obj::Tuple& kv = obj::get<obj::Tuple>(params[i]);
+
+            const UrlParts::param_t& p = parts.params[i];
+
+            obj::get<obj::String>(kv.v[0]).v.assign(parts.url, p.key, p.keylen);
+            obj::get<obj::String>(kv.v[1]).v = parts.value(i);
+        }
+    }
+};
+
+void url_parse(const obj::Object* in, obj::Object*& out) {
+
+    obj::get<UrlParse>(out).set(url_parts(obj::get<obj::String>(in).v));
 }
 
 struct UrlGetter {
@@ -247,9 +449,22 @@ Functions::func_t url_getparam_checker(const Type& args, Type& ret, obj::Object*
     return nullptr;
 }
 
+Functions::func_t url_parse_checker(const Type& args, Type& ret, obj::Object*& obj) {
+
+    if (args != Type(Type::STRING))
+        return nullptr;
+
+    ret = Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING), Type(Type::STRING),
+                            Type(Type::ARR, { Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) }) }) });
+
+    obj = new UrlParse;
+    return url_parse;
+}
+
 void register_url(Functions& funcs) {
 
     funcs.add_poly("url_getparam", url_getparam_checker);
+    funcs.add_poly("url_parse", url_parse_checker);
 }
 
 #endif
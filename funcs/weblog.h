@@ -0,0 +1,439 @@
+#ifndef __TAB_FUNCS_WEBLOG_H
+#define __TAB_FUNCS_WEBLOG_H
+
+// Parses web server access logs in one pass, without regexes. A log format is given
+// as an nginx 'log_format' spec: '$variable' fields separated by literal text.
+// Each field runs up to the literal text that follows it, which is found with memchr();
+// inside double quotes, quotes escaped with a backslash are skipped over.
+
+struct WeblogFormat {
+
+    enum field_t {
+        SKIP,
+        IP,
+        TIME,
+        REQUEST,
+        METHOD,
+        URI,
+        STATUS,
+        BYTES,
+        REFERRER,
+        AGENT
+    };
+
+    struct step_t {
+        std::string before;
+        field_t field;
+        bool quoted;
+    };
+
+    std::string src;
+    std::vector<step_t> steps;
+    std::string tail;
+    bool compiled;
+
+    WeblogFormat() : compiled(false) {}
+
+    static const std::string& named(const std::string& name) {
+
+        static const std::string combined =
+            "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent "
+            "\"$http_referer\" \"$http_user_agent\"";
+
+        static const std::string common =
+            "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent";
+
+        if (name == "combined" || name == "nginx")
+            return combined;
+
+        if (name == "common")
+            return common;
+
+        if (name.find('$') == std::string::npos)
+            throw std::runtime_error("Unknown log format in 'weblog': '" + name + "'");
+
+        return name;
+    }
+
+    static field_t variable(const std::string& v) {
+
+        static const std::unordered_map<std::string, field_t> vars = {
+            { "remote_addr", IP },
+            { "time_local", TIME },
+            { "request", REQUEST },
+            { "request_method", METHOD },
+            { "request_uri", URI },
+            { "status", STATUS },
+            { "body_bytes_sent", BYTES },
+            { "bytes_sent", BYTES },
+            { "http_referer", REFERRER },
+            { "http_user_agent", AGENT }
+        };
+
+        auto i = vars.find(v);
+        return (i == vars.end() ? SKIP : i->second);
+    }
+
+    // Compiles the format once; calls with the same format string (e.g. a literal) reuse it.
+    void compile(const std::string& name) {
+
+        if (compiled && name == src)
+            return;
+
+        const std::string& spec = named(name);
+
+        src = name;
+        steps.clear();
+        tail.clear();
+
+        std::string text;
+        size_t i = 0;
+
+        while (i < spec.size()) {
+
+            if (spec[i] != '$') {
+                text += spec[i];
+                ++i;
+                continue;
+            }
+
+            size_t j = i + 1;
+
+            while (j < spec.size() && (spec[j] == '_' || (spec[j] >= '0' && spec[j] <= '9') ||
+                                       ((spec[j] | 0x20) >= 'a' && (spec[j] | 0x20) <= 'z')))
+                ++j;
+
+            if (j == i + 1) {
+                text += spec[i];
+                ++i;
+                continue;
+            }
+
+            if (!steps.empty() && text.empty())
+                throw std::runtime_error("Fields of a log format must be separated by some text: '" + spec + "'");
+
+            bool quoted = (!text.empty() && text.back() == '"');
+
+            steps.push_back(step_t{ text, variable(spec.substr(i + 1, j - i - 1)), quoted });
+            text.clear();
+            i = j;
+        }
+
+        tail = text;
+        compiled = true;
+    }
+};
+
+namespace weblog {
+
+// Finds 'lit' at or after 'p'; with 'quoted', skips quotes escaped with a backslash.
+inline const char* find_text(const char* p, const char* e, const std::string& lit, bool quoted) {
+
+    const char* s = p;
+
+    while (1) {
+
+        const char* q = (const char*)::memchr(s, lit[0], e - s);
+
+        if (!q)
+            return nullptr;
+
+        if (quoted && lit[0] == '"') {
+
+            const char* b = q;
+
+            while (b != p && b[-1] == '\\')
+                --b;
+
+            if ((q - b) & 1) {
+                s = q + 1;
+                continue;
+            }
+        }
+
+        if ((size_t)(e - q) >= lit.size() && ::memcmp(q, lit.data(), lit.size()) == 0)
+            return q;
+
+        s = q + 1;
+    }
+}
+
+inline bool digits(const char*& p, const char* e, int n, int& out) {
+
+    out = 0;
+
+    for (int i = 0; i < n; ++i, ++p) {
+
+        if (p == e || *p < '0' || *p > '9')
+            return false;
+
+        out = out * 10 + (*p - '0');
+    }
+
+    return true;
+}
+
+inline bool expect(const char*& p, const char* e, char c) {
+
+    if (p == e || *p != c)
+        return false;
+
+    ++p;
+    return true;
+}
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+inline Int days_from_civil(Int y, int m, int d) {
+
+    y -= (m <= 2);
+
+    Int era = (y >= 0 ? y : y - 399) / 400;
+    Int yoe = y - era * 400;
+    Int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    Int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+// Parses '10/Oct/2000:13:55:36 -0700' into a UNIX timestamp.
+inline bool parse_time(const char* p, const char* e, Int& out) {
+
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    int day, year, hour, minute, second, zh, zm;
+
+    if (!digits(p, e, 2, day) || !expect(p, e, '/') || e - p < 3)
+        return false;
+
+    const char* m = (const char*)::memmem(months, 36, p, 3);
+
+    if (!m || (m - months) % 3 != 0)
+        return false;
+
+    int month = (m - months) / 3 + 1;
+    p += 3;
+
+    if (!expect(p, e, '/') || !digits(p, e, 4, year) || !expect(p, e, ':') ||
+        !digits(p, e, 2, hour) || !expect(p, e, ':') ||
+        !digits(p, e, 2, minute) || !expect(p, e, ':') ||
+        !digits(p, e, 2, second) || !expect(p, e, ' ') || p == e)
+        return false;
+
+    char sign = *p++;
+
+    if ((sign != '+' && sign != '-') || !digits(p, e, 2, zh) || !digits(p, e, 2, zm) || p != e)
+        return false;
+
+    Int offset = (zh * 60 + zm) * 60;
+
+    out = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    out -= (sign == '+' ? offset : -offset);
+    return true;
+}
+
+// '-' stands for no bytes sent.
+inline bool parse_count(const char* p, const char* e, UInt& out) {
+
+    if (e - p == 1 && *p == '-') {
+        out = 0;
+        return true;
+    }
+
+    return (p != e && *p >= '0' && *p <= '9' && parse_uint(p, e, out, 10) == e);
+}
+
+} // namespace weblog
+
+// The result tuple: (ip, ts, method, path, query, status, bytes, referrer, agent).
+struct Weblog : public obj::Tuple {
+
+    WeblogFormat format;
+
+    Weblog() {
+        v.push_back(new obj::String);
+        v.push_back(new obj::Int);
+        v.push_back(new obj::String);
+        v.push_back(new obj::String);
+        v.push_back(new obj::String);
+        v.push_back(new obj::UInt);
+        v.push_back(new obj::UInt);
+        v.push_back(new obj::String);
+        v.push_back(new obj::String);
+    }
+
+    std::string& str(size_t i) { return obj::get<obj::String>(v[i]).v; }
+
+    // Fields that are not in the format stay empty.
+    void compile(const std::string& f) {
+
+        if (format.compiled && f == format.src)
+            return;
+
+        format.compile(f);
+
+        for (size_t i : { 0, 2, 3, 4, 7, 8 }) {
+            str(i).clear();
+        }
+
+        obj::get<obj::Int>(v[1]).v = 0;
+        obj::get<obj::UInt>(v[5]).v = 0;
+        obj::get<obj::UInt>(v[6]).v = 0;
+    }
+
+    void set_uri(const char* b, const char* e) {
+
+        const char* q = (const char*)::memchr(b, '?', e - b);
+
+        if (q) {
+            str(3).assign(b, q);
+            str(4).assign(q + 1, e);
+
+        } else {
+            str(3).assign(b, e);
+            str(4).clear();
+        }
+    }
+
+    // 'GET /path?query HTTP/1.1'; the protocol is dropped.
+    void set_request(const char* b, const char* e) {
+
+        const char* s1 = (const char*)::memchr(b, ' ', e - b);
+
+        if (!s1) {
+            str(2).clear();
+            set_uri(b, e);
+            return;
+        }
+
+        str(2).assign(b, s1);
+
+        const char* s2 = (const char*)::memrchr(s1 + 1, ' ', e - s1 - 1);
+
+        set_uri(s1 + 1, s2 ? s2 : e);
+    }
+
+    bool field(WeblogFormat::field_t f, const char* b, const char* e) {
+
+        switch (f) {
+        case WeblogFormat::SKIP:
+            break;
+        case WeblogFormat::IP:
+            str(0).assign(b, e);
+            break;
+        case WeblogFormat::TIME:
+            return weblog::parse_time(b, e, obj::get<obj::Int>(v[1]).v);
+        case WeblogFormat::REQUEST:
+            set_request(b, e);
+            break;
+        case WeblogFormat::METHOD:
+            str(2).assign(b, e);
+            break;
+        case WeblogFormat::URI:
+            set_uri(b, e);
+            break;
+        case WeblogFormat::STATUS:
+            return weblog::parse_count(b, e, obj::get<obj::UInt>(v[5]).v);
+        case WeblogFormat::BYTES:
+            return weblog::parse_count(b, e, obj::get<obj::UInt>(v[6]).v);
+        case WeblogFormat::REFERRER:
+            str(7).assign(b, e);
+            break;
+        case WeblogFormat::AGENT:
+            str(8).assign(b, e);
+            break;
+        }
+
+        return true;
+    }
+
+    void parse(const std::string& line) {
+
+        const char* p = line.data();
+        const char* e = p + line.size();
+
+        const std::vector<WeblogFormat::step_t>& steps = format.steps;
+
+        for (size_t i = 0; i < steps.size(); ++i) {
+
+            const std::string& before = steps[i].before;
+
+            if ((size_t)(e - p) < before.size() || ::memcmp(p, before.data(), before.size()) != 0)
+                throw std::runtime_error("Malformed line in 'weblog'");
+
+            p += before.size();
+
+            const std::string& after = (i + 1 < steps.size() ? steps[i + 1].before : format.tail);
+            const char* x = (after.empty() ? e : weblog::find_text(p, e, after, steps[i].quoted));
+
+            if (!x || !field(steps[i].field, p, x))
+                throw std::runtime_error("Malformed line in 'weblog'");
+
+            p = x;
+        }
+
+        // Text after the closing text of the format, e.g. fields added to the format, is ignored.
+        if ((size_t)(e - p) < format.tail.size() || ::memcmp(p, format.tail.data(), format.tail.size()) != 0)
+            throw std::runtime_error("Malformed line in 'weblog'");
+    }
+};
+
+// With LITERAL, the format was compiled when the program was type-checked.
+template <bool LITERAL>
+void weblog_parse(const obj::Object* in, obj::Object*& out) {
+
+    Weblog& ret = obj::get<Weblog>(out);
+
+    if (LITERAL) {
+        ret.parse(obj::get<obj::String>(in).v);
+        return;
+    }
+
+    obj::Tuple& args = obj::get<obj::Tuple>(in);
+
+    ret.compile(obj::get<obj::String>(args.v[1]).v);
+    ret.parse(obj::get<obj::String>(args.v[0]).v);
+}
+
+void weblog_parse_format(const obj::Object* in, obj::Object*& out) {
+
+    weblog_parse<true>(obj::get<obj::Tuple>(in).v[0], out);
+}
+
+Functions::func_t weblog_checker(const Type& args, Type& ret, obj::Object*& obj) {
+
+    ret = Type(Type::TUP, { Type(Type::STRING), Type(Type::INT), Type(Type::STRING),
+                            Type(Type::STRING), Type(Type::STRING), Type(Type::UINT),
+                            Type(Type::UINT), Type(Type::STRING), Type(Type::STRING) });
+
+    if (args == Type(Type::STRING)) {
+
+        Weblog* w = new Weblog;
+        w->compile("combined");
+        obj = w;
+
+        return weblog_parse<true>;
+    }
+
+    if (args == Type(Type::TUP, { Type(Type::STRING), Type(Type::STRING) })) {
+
+        Weblog* w = new Weblog;
+        obj = w;
+
+        const std::string* format = literal_string(args.tuple->at(1));
+
+        if (!format)
+            return weblog_parse<false>;
+
+        w->compile(*format);
+        return weblog_parse_format;
+    }
+
+    return nullptr;
+}
+
+void register_weblog(Functions& funcs) {
+
+    funcs.add_poly("weblog", weblog_checker);
+}
+
+#endif
@@ -136,8 +136,9 @@ static const char* _help[][2] = {
      "thread will collect the results of all other threads, aggregate them,\n"
      "and output the final answer. Separate the 'scatter' CPU-intensive\n"
      "expression from the 'gather' aggregation expression with a special\n"
-     "'-->' token. If a 'gather' expression is not specified, then a default\n"
-     "\"@\" will be automatically assumed.\n"
+     "'-->' token. If a 'gather' expression is not specified, then there is\n"
+     "nothing to aggregate: every thread prints its own results as whole\n"
+     "lines, in no particular order between threads.\n"
      "\n"
      "Examples:\n"
      "\n"
@@ -150,13 +151,14 @@ static const char* _help[][2] = {
     },
 
     { "functions",
-      "\nabs add and array avg box bytes case cat ceil combo cos count cut date datetime\n"
-      "e eq exp explode file filter find findif first flatten flip floor get glue gmtime\n"
-      "grep grepif has hash head hex hist if iarray index int join lines log lsh map\n"
-      "max mean merge min mul ngrams normal now open or pairs peek pi product rand real\n"
-      "recut replace resplit reverse round rsh sample second seq sin skip sort sorted\n"
-      "split sqrt stddev stdev string sum take tan tabulate time tolower toupper triplets\n"
-      "tuple uint unflatten uniques uniques_estimate until url_getparam var variance while zip\n"
+      "\nabs add and array avg box bytes case cat ceil combo cos count csv cut date\n"
+      "datetime e eq exp explode file filename filter find findif first flatten flip\n"
+      "floor get glue gmtime grep grepif has hash head hex hist iarray if index int\n"
+      "join json lines log lsh map max mean merge min mul ngrams normal now open or\n"
+      "pairs peek pi product rand real recut replace resplit reverse round rsh sample\n"
+      "second seq sin skip sort sorted split sqrt stddev stdev string sum tabulate take\n"
+      "tan time tolower toupper triplets tuple uint unflatten uniques uniques_estimate\n"
+      "until url_getparam url_parse var variance weblog while zip\n"
     },
 
     {"abs",
@@ -310,6 +312,25 @@ static const char* _help[][2] = {
      "count Arr[a] -> UInt\n"
      "    returns the number of elements in the array.\n"
     },
+    {"csv",
+     "\n"
+     "Splits a CSV record into fields, following RFC 4180: a field in double\n"
+     "quotes may contain the delimiter, newlines and doubled quotes (\"\") that stand\n"
+     "for one quote character. A trailing carriage return is removed. Use '-R csv'\n"
+     "to read records whose quoted fields span several lines.\n"
+     "\n"
+     "Usage:\n"
+     "\n"
+     "csv String -> Arr[String]\n"
+     "    splits the record on commas.\n"
+     "\n"
+     "csv String, String -> Arr[String]\n"
+     "    splits the record on the given delimiter, which must be a single byte.\n"
+     "\n"
+     "csv Seq[String] -> Seq[Arr[String]]\n"
+     "csv Seq[String], String -> Seq[Arr[String]]\n"
+     "    equivalent to [ csv(@) : seq ] and [ csv(@,delim) : seq ].\n"
+    },
     {"cut",
      "\n"
      "Splits a string using a delimiter. See also 'recut' for splitting with\n"
@@ -385,12 +406,23 @@ static const char* _help[][2] = {
      "\n"
      "Opens a file and returns the lines in the file as a sequence of\n"
      "strings. (This allows a tab expression to process several files\n"
-     "instead of just one.)\n"
+     "instead of just one.) Gzip-compressed files are decompressed\n"
+     "automatically.\n"
      "\n"
      "Usage:\n"
      "\n"
      "file String -> Seq[String]\n"
     },
+    {"filename",
+     "\n"
+     "Returns the name of the input file currently being read. Useful when\n"
+     "several input files are given with '-i'. Returns an empty string when\n"
+     "reading from standard input.\n"
+     "\n"
+     "Usage:\n"
+     "\n"
+     "filename None -> String\n"
+    },
     {"filter",
      "\n"
      "Filters a sequence by returning an equivalent sequence but with\n"
@@ -519,7 +551,9 @@ static const char* _help[][2] = {
      "Finds regular expression matches in a string. The first argument is\n"
      "the string to match in, the second argument is the regular\n"
      "expression. Matches are returned in an array of strings. Regular\n"
-     "expressions use ECMAScript syntax. See also: 'grepif', 'find', 'findif'.\n"
+     "expressions use ECMAScript syntax. Matching takes time linear in the\n"
+     "length of the string, except for patterns with backreferences or\n"
+     "lookahead. See also: 'grepif', 'find', 'findif'.\n"
      "\n"
      "Usage:\n"
      "\n"
@@ -694,6 +728,26 @@ static const char* _help[][2] = {
      "\n"
      "join String, Seq[String], String, String -> String\n"
     },
+    {"json",
+     "\n"
+     "Extracts values from a JSON document by path, such as 'a.b[2].c': object\n"
+     "keys are separated by dots and array elements are selected with [N]. Only\n"
+     "the parts of the document on the path are parsed; everything else is\n"
+     "skipped. Strings are returned unescaped, other values as JSON text.\n"
+     "\n"
+     "Usage:\n"
+     "\n"
+     "json String, String -> String\n"
+     "    returns the value at the path. It is an error if the path is not found.\n"
+     "\n"
+     "json String, String, a -> a\n"
+     "    where 'a' is Int, UInt or Real: returns the value at the path converted\n"
+     "    to a number, or the third argument if the path is not found or the value\n"
+     "    is not a number.\n"
+     "\n"
+     "json String, String, String, ... -> (String, String, ...)\n"
+     "    returns a tuple of the values at several paths.\n"
+    },
     {"lines",
      "\n"
      "Returns its arguments as a tuple, except that each element will be printed\n"
@@ -1023,6 +1077,9 @@ static const char* _help[][2] = {
      "Accepts a sequence or array and returns an equivalent sequence where\n"
      "the first N elements are ignored. See also: 'head', 'stripe'.\n"
      "\n"
+     "Skipped lines of the input are not copied; if the input file has a line\n"
+     "offset index (see 'tab --build-index'), skipping seeks straight to the line.\n"
+     "\n"
      "Usage:\n"
      "\n"
      "skip Seq[a], UInt -> Seq[a]\n"
@@ -1290,6 +1347,20 @@ static const char* _help[][2] = {
      "    Example: 'url_getparam.\"&one=1&two=2\"' will return a value\n"
      "    equivalent to 'seq(tuple(\"one\",\"1\"), tuple(\"two\",\"2\"))'.\n"
     },
+    {"url_parse",
+     "\n"
+     "Splits a URL into its scheme, host, path and query-string parameters.\n"
+     "The parameters are the same key/value pairs that 'url_getparam' finds,\n"
+     "and values are percent-decoded. The URL is scanned once; 'url_getparam'\n"
+     "calls on the same URL reuse the result, so asking for several parameters\n"
+     "of one URL does not rescan it.\n"
+     "\n"
+     "Usage:\n"
+     "\n"
+     "url_parse String -> (String, String, String, Arr[(String,String)])\n"
+     "    Example: 'url_parse(\"http://example.com/a?q=1&p=2\")' will return a value\n"
+     "    equivalent to '(\"http\", \"example.com\", \"/a\", [(\"q\",\"1\"), (\"p\",\"2\")])'.\n"
+    },
     {"var",
      "\n"
      "Calculates the sample variance of a sequence of numbers. (Defined as\n"
@@ -1311,6 +1382,28 @@ static const char* _help[][2] = {
      "\n"
      "Synonym for 'var'.\n"
     },
+    {"weblog",
+     "\n"
+     "Parses a line of a web server access log in a single pass. The format is\n"
+     "'combined' (also called 'nginx'), 'common', or an nginx 'log_format' spec,\n"
+     "where each field is a '$variable' and fields are separated by literal text.\n"
+     "The recognized variables are $remote_addr, $time_local, $request,\n"
+     "$request_method, $request_uri, $status, $body_bytes_sent, $bytes_sent,\n"
+     "$http_referer and $http_user_agent; other variables are skipped. Fields\n"
+     "missing from the format are returned as empty strings or zero. It is an\n"
+     "error if a line does not match the format; use 'try' to skip such lines.\n"
+     "\n"
+     "Usage:\n"
+     "\n"
+     "weblog String -> (String, Int, String, String, String, UInt, UInt, String, String)\n"
+     "    parses a line in the 'combined' format and returns the tuple (ip,\n"
+     "    timestamp, method, path, query, status, bytes, referrer, user agent).\n"
+     "    The timestamp is a UNIX time, the query is the part of the request URI\n"
+     "    after '?', and a '-' for the bytes is returned as zero.\n"
+     "\n"
+     "weblog String, String -> (String, Int, String, String, String, UInt, UInt, String, String)\n"
+     "    parses a line in the format given by the second argument.\n"
+    },
     {"while",
      "\n"
      "Similar to 'filter', but stops the output sequence once the first\n"
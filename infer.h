@@ -19,6 +19,24 @@ struct Functions {
     typedef obj::Object* (*seqmaker_t)(const Type& arg);
 
     seqmaker_t seqmaker;
+
+    // Makes the result object of a function replaced by its viewer; see optimize().
+    typedef obj::Object* (*viewmaker_t)();
+
+    viewmaker_t viewmaker;
+
+    // A function whose result is only passed on to a second function can be replaced by
+    // a single function that does both; see optimize().
+    std::map< std::pair<func_t, func_t>, func_t > fusions;
+
+    // A function returning a string can have a variant that returns an obj::StringView into
+    // its argument instead; it is used only when the result goes straight into a consumer
+    // registered in 'view_takers' for that argument position, which never keeps the value.
+    std::map< func_t, func_t > viewers;
+    std::map< std::pair<func_t, size_t>, func_t > view_takers;
+
+    // Argument position of a consumer that takes the whole value rather than a tuple element.
+    static const size_t WHOLE_ARG = (size_t)-1;
     
     Functions() {}
 
@@ -37,6 +55,40 @@ struct Functions {
         seqmaker = sm;
     }
 
+    void add_viewmaker(viewmaker_t vm) {
+        viewmaker = vm;
+    }
+
+    void add_fusion(func_t first, func_t second, func_t fused) {
+        fusions[std::make_pair(first, second)] = fused;
+    }
+
+    func_t fused(func_t first, func_t second) const {
+
+        auto i = fusions.find(std::make_pair(first, second));
+        return (i == fusions.end() ? nullptr : i->second);
+    }
+
+    void add_viewer(func_t f, func_t viewer) {
+        viewers[f] = viewer;
+    }
+
+    func_t viewer(func_t f) const {
+
+        auto i = viewers.find(f);
+        return (i == viewers.end() ? nullptr : i->second);
+    }
+
+    void add_view_taker(func_t f, size_t arg, func_t taker) {
+        view_takers[std::make_pair(f, arg)] = taker;
+    }
+
+    func_t view_taker(func_t f, size_t arg) const {
+
+        auto i = view_takers.find(std::make_pair(f, arg));
+        return (i == view_takers.end() ? nullptr : i->second);
+    }
+
     val_t get(const String& name, const Type& args, obj::Object*& holder) const {
             
         auto i = funcs.find(key_t(name, args));
@@ -92,6 +144,32 @@ bool check_string(const Type& t) {
     return (t.type == Type::ATOM && t.atom == Type::STRING);
 }
 
+// The value of a string literal argument, so that checkers can prepare for it when the
+// program is compiled; nullptr if the value is only known at runtime.
+const std::string* literal_string(const Type& t) {
+
+    if (!check_string(t) || !t.literal || t.literal->which != Atom::STRING)
+        return nullptr;
+
+    return &strings().get(t.literal->str);
+}
+
+// Only a literal itself has a value known at compile time; a function result does not,
+// even when the function passes on one of its arguments (e.g. a default in 'get').
+void clear_literals(Type& t) {
+
+    t.literal.reset();
+
+    if (t.tuple) {
+
+        t.tuple = std::make_shared< std::vector<Type> >(*t.tuple);
+
+        for (Type& x : *t.tuple) {
+            clear_literals(x);
+        }
+    }
+}
+
 std::vector<Command>::iterator
 handle_real_operator(std::vector<Command>& commands, std::vector<Command>::iterator ci,
                      std::vector<Type>& stack, const std::string& name) {
@@ -712,6 +790,7 @@ Type infer_expr(std::vector<Command>& commands, TypeRuntime& typer, bool allow_e
                 typer.unget_def();
 
                 stack.emplace_back(t);
+                clear_literals(stack.back());
 
                 if (args.type != Type::NONE) {
 
@@ -737,6 +816,7 @@ Type infer_expr(std::vector<Command>& commands, TypeRuntime& typer, bool allow_e
                 auto tmp = functions().get(c.arg.str, args, c.object);
                 c.function = (void*)tmp.first;
                 stack.emplace_back(tmp.second);
+                clear_literals(stack.back());
 
                 if (typer.debug) {
                     std::cout << " " << strings().get(c.arg.str) << " " << Type::print(args) << " -> " << Type::print(tmp.second) << std::endl;
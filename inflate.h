@@ -0,0 +1,558 @@
+#ifndef __TAB_INFLATE_H
+#define __TAB_INFLATE_H
+
+namespace tab {
+
+// A self-contained gzip (RFC 1952) and DEFLATE (RFC 1951) decoder.
+// Output is produced one or more whole DEFLATE blocks at a time.
+
+bool is_gzip(const char* b, const char* e) {
+    return (e - b >= 2 && (unsigned char)b[0] == 0x1f && (unsigned char)b[1] == 0x8b);
+}
+
+struct Inflater {
+
+    typedef std::function<bool(const char*&, const char*&)> fetch_t;
+
+    static const size_t WINDOW = 32*1024;
+    static const size_t CHUNK = 256*1024;
+    static const unsigned int FASTBITS = 10;
+
+    struct Huffman {
+        uint16_t count[16];
+        uint16_t symbol[288];
+        uint16_t fast[1 << FASTBITS];
+
+        void build(const uint8_t* lengths, unsigned int n) {
+
+            std::fill(count, count + 16, 0);
+            std::fill(fast, fast + (1 << FASTBITS), 0);
+
+            for (unsigned int i = 0; i < n; ++i) {
+                count[lengths[i]]++;
+            }
+
+            count[0] = 0;
+
+            uint16_t offs[16];
+            uint16_t next_code[16];
+            offs[1] = 0;
+            next_code[1] = 0;
+
+            for (unsigned int len = 1; len < 15; ++len) {
+                offs[len + 1] = offs[len] + count[len];
+                next_code[len + 1] = (next_code[len] + count[len]) << 1;
+            }
+
+            for (unsigned int i = 0; i < n; ++i) {
+
+                unsigned int len = lengths[i];
+
+                if (len == 0)
+                    continue;
+
+                symbol[offs[len]++] = i;
+
+                unsigned int code = next_code[len]++;
+
+                if (len > FASTBITS)
+                    continue;
+
+                // Codes are packed starting from the most significant bit.
+                unsigned int rev = 0;
+
+                for (unsigned int j = 0; j < len; ++j) {
+                    rev = (rev << 1) | ((code >> j) & 1);
+                }
+
+                for (unsigned int j = rev; j < (1u << FASTBITS); j += (1u << len)) {
+                    fast[j] = (len << 9) | i;
+                }
+            }
+        }
+    };
+
+    fetch_t fetch;
+    const unsigned char* in_b;
+    const unsigned char* in_e;
+    bool in_eof;
+
+    uint64_t bitbuf;
+    unsigned int bitcnt;
+
+    std::vector<unsigned char> out;
+    size_t out_start;
+
+    enum {
+        HEADER,
+        BLOCK,
+        TRAILER,
+        DONE
+    } state;
+
+    bool last_block;
+    uint32_t crc;
+    uint32_t isize;
+
+    Huffman dynlen;
+    Huffman dyndist;
+    const Huffman* lencode;
+    const Huffman* distcode;
+
+    Inflater(const char* b, const char* e, fetch_t f = fetch_t()) :
+        fetch(f), in_b((const unsigned char*)b), in_e((const unsigned char*)e), in_eof(false),
+        bitbuf(0), bitcnt(0), out_start(0), state(HEADER), last_block(false), crc(0), isize(0),
+        lencode(nullptr), distcode(nullptr)
+        {
+            out.reserve(WINDOW + CHUNK * 2);
+        }
+
+    struct CrcTable {
+        uint32_t table[256];
+
+        CrcTable() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1);
+                }
+
+                table[i] = c;
+            }
+        }
+    };
+
+    void update_crc(const unsigned char* b, const unsigned char* e) {
+
+        static const CrcTable crcs;
+
+        const uint32_t* table = crcs.table;
+        uint32_t c = ~crc;
+
+        isize += (e - b);
+
+        for (; b != e; ++b) {
+            c = table[(c ^ *b) & 0xFF] ^ (c >> 8);
+        }
+
+        crc = ~c;
+    }
+
+    bool more_input() {
+
+        if (in_b != in_e)
+            return true;
+
+        if (in_eof || !fetch)
+            return false;
+
+        const char* b;
+        const char* e;
+
+        while (fetch(b, e)) {
+
+            if (b != e) {
+                in_b = (const unsigned char*)b;
+                in_e = (const unsigned char*)e;
+                return true;
+            }
+        }
+
+        in_eof = true;
+        return false;
+    }
+
+    void refill() {
+
+        while (bitcnt <= 56) {
+
+            if (in_b == in_e && !more_input())
+                return;
+
+            bitbuf |= (uint64_t)(*in_b) << bitcnt;
+            ++in_b;
+            bitcnt += 8;
+        }
+    }
+
+    uint32_t bits(unsigned int n) {
+
+        if (bitcnt < n) {
+            refill();
+
+            if (bitcnt < n)
+                throw std::runtime_error("Unexpected end of gzip data.");
+        }
+
+        uint32_t ret = bitbuf & ((1ULL << n) - 1);
+        bitbuf >>= n;
+        bitcnt -= n;
+        return ret;
+    }
+
+    void align() {
+        bits(bitcnt % 8);
+    }
+
+    bool at_end() {
+
+        if (bitcnt > 0)
+            return false;
+
+        return !more_input();
+    }
+
+    unsigned int decode(const Huffman& h) {
+
+        if (bitcnt < 15) {
+            refill();
+        }
+
+        unsigned int f = h.fast[bitbuf & ((1 << FASTBITS) - 1)];
+
+        if (f != 0) {
+            unsigned int len = f >> 9;
+
+            if (len > bitcnt)
+                throw std::runtime_error("Unexpected end of gzip data.");
+
+            bitbuf >>= len;
+            bitcnt -= len;
+            return f & 511;
+        }
+
+        int code = 0;
+        int first = 0;
+        int index = 0;
+
+        for (unsigned int len = 1; len <= 15 && len <= bitcnt; ++len) {
+
+            code |= (bitbuf >> (len - 1)) & 1;
+
+            int count = h.count[len];
+
+            if (code - count < first) {
+                bitbuf >>= len;
+                bitcnt -= len;
+                return h.symbol[index + (code - first)];
+            }
+
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+
+        throw std::runtime_error("Invalid Huffman code in gzip data.");
+    }
+
+    void read_header() {
+
+        if (bits(8) != 0x1f || bits(8) != 0x8b)
+            throw std::runtime_error("Not a gzip file.");
+
+        if (bits(8) != 8)
+            throw std::runtime_error("Unknown gzip compression method.");
+
+        unsigned int flags = bits(8);
+
+        // mtime, xfl, os
+        bits(32);
+        bits(16);
+
+        if (flags & 4) {
+            unsigned int xlen = bits(16);
+
+            for (unsigned int i = 0; i < xlen; ++i) {
+                bits(8);
+            }
+        }
+
+        if (flags & 8) {
+            while (bits(8) != 0) {}
+        }
+
+        if (flags & 16) {
+            while (bits(8) != 0) {}
+        }
+
+        if (flags & 2) {
+            bits(16);
+        }
+
+        crc = 0;
+        isize = 0;
+        last_block = false;
+        state = BLOCK;
+    }
+
+    void read_trailer() {
+
+        align();
+
+        uint32_t c = bits(32);
+        uint32_t s = bits(32);
+
+        if (c != crc || s != isize)
+            throw std::runtime_error("Corrupt gzip data: checksum mismatch.");
+
+        // Concatenated gzip members are decoded as one stream; anything else is trailing garbage.
+        if (at_end()) {
+            state = DONE;
+            return;
+        }
+
+        refill();
+
+        if (bitcnt < 16 || (bitbuf & 0xFFFF) != 0x8b1f) {
+            state = DONE;
+            return;
+        }
+
+        state = HEADER;
+    }
+
+    void stored_block() {
+
+        align();
+
+        unsigned int len = bits(16);
+        unsigned int nlen = bits(16);
+
+        if (len != (~nlen & 0xFFFF))
+            throw std::runtime_error("Corrupt gzip data: bad stored block length.");
+
+        for (unsigned int i = 0; i < len; ++i) {
+            out.push_back(bits(8));
+        }
+    }
+
+    struct FixedTables {
+        Huffman len;
+        Huffman dist;
+
+        FixedTables() {
+            uint8_t lengths[288];
+
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            len.build(lengths, 288);
+
+            std::fill(lengths, lengths + 30, 5);
+            dist.build(lengths, 30);
+        }
+    };
+
+    void fixed_tables() {
+
+        static const FixedTables fixed;
+
+        lencode = &fixed.len;
+        distcode = &fixed.dist;
+    }
+
+    void dynamic_tables() {
+
+        static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        unsigned int nlen = bits(5) + 257;
+        unsigned int ndist = bits(5) + 1;
+        unsigned int ncode = bits(4) + 4;
+
+        if (nlen > 286 || ndist > 30)
+            throw std::runtime_error("Corrupt gzip data: bad code lengths.");
+
+        uint8_t lengths[320];
+        std::fill(lengths, lengths + 19, 0);
+
+        for (unsigned int i = 0; i < ncode; ++i) {
+            lengths[order[i]] = bits(3);
+        }
+
+        Huffman lencodes;
+        lencodes.build(lengths, 19);
+
+        unsigned int i = 0;
+
+        while (i < nlen + ndist) {
+
+            unsigned int sym = decode(lencodes);
+
+            if (sym < 16) {
+                lengths[i++] = sym;
+                continue;
+            }
+
+            unsigned int len = 0;
+            unsigned int rep;
+
+            if (sym == 16) {
+
+                if (i == 0)
+                    throw std::runtime_error("Corrupt gzip data: repeat with no first length.");
+
+                len = lengths[i - 1];
+                rep = 3 + bits(2);
+
+            } else if (sym == 17) {
+                rep = 3 + bits(3);
+
+            } else {
+                rep = 11 + bits(7);
+            }
+
+            if (i + rep > nlen + ndist)
+                throw std::runtime_error("Corrupt gzip data: too many code lengths.");
+
+            while (rep--) {
+                lengths[i++] = len;
+            }
+        }
+
+        if (lengths[256] == 0)
+            throw std::runtime_error("Corrupt gzip data: no end-of-block code.");
+
+        dynlen.build(lengths, nlen);
+        dyndist.build(lengths + nlen, ndist);
+
+        lencode = &dynlen;
+        distcode = &dyndist;
+    }
+
+    void codes() {
+
+        static const uint16_t lbase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t lext[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t dbase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+            8193, 12289, 16385, 24577 };
+        static const uint8_t dext[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+            12, 12, 13, 13 };
+
+        while (1) {
+
+            unsigned int sym = decode(*lencode);
+
+            if (sym < 256) {
+                out.push_back(sym);
+                continue;
+            }
+
+            if (sym == 256)
+                return;
+
+            sym -= 257;
+
+            if (sym >= 29)
+                throw std::runtime_error("Corrupt gzip data: bad length code.");
+
+            size_t len = lbase[sym] + bits(lext[sym]);
+
+            unsigned int dsym = decode(*distcode);
+
+            if (dsym >= 30)
+                throw std::runtime_error("Corrupt gzip data: bad distance code.");
+
+            size_t dist = dbase[dsym] + bits(dext[dsym]);
+
+            if (dist > out.size())
+                throw std::runtime_error("Corrupt gzip data: distance too far back.");
+
+            size_t from = out.size() - dist;
+
+            if (dist >= len) {
+
+                if (out.capacity() < out.size() + len) {
+                    out.reserve(out.capacity() * 2);
+                }
+
+                out.insert(out.end(), out.begin() + from, out.begin() + from + len);
+
+            } else {
+
+                // The source and destination overlap, so copy byte by byte.
+                for (size_t i = 0; i < len; ++i) {
+                    out.push_back(out[from + i]);
+                }
+            }
+        }
+    }
+
+    void block() {
+
+        size_t start = out.size();
+
+        last_block = bits(1);
+        unsigned int type = bits(2);
+
+        switch (type) {
+        case 0:
+            stored_block();
+            break;
+        case 1:
+            fixed_tables();
+            codes();
+            break;
+        case 2:
+            dynamic_tables();
+            codes();
+            break;
+        default:
+            throw std::runtime_error("Corrupt gzip data: bad block type.");
+        }
+
+        update_crc(out.data() + start, out.data() + out.size());
+
+        if (last_block) {
+            state = TRAILER;
+        }
+    }
+
+    // Decompresses the next chunk of data into [b, e); returns false once the stream is finished.
+    // The returned pointers are valid until the next call.
+    bool next(const char*& b, const char*& e) {
+
+        // Keep the last 32K of output as the history for back-references.
+        if (out.size() > WINDOW) {
+            out.erase(out.begin(), out.end() - WINDOW);
+        }
+
+        out_start = out.size();
+
+        while (state != DONE && out.size() - out_start < CHUNK) {
+
+            switch (state) {
+            case HEADER:
+                read_header();
+                break;
+            case BLOCK:
+                block();
+                break;
+            case TRAILER:
+                read_trailer();
+                break;
+            case DONE:
+                break;
+            }
+        }
+
+        b = (const char*)out.data() + out_start;
+        e = (const char*)out.data() + out.size();
+
+        return (b != e);
+    }
+};
+
+} // namespace tab
+
+#endif
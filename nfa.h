@@ -0,0 +1,1144 @@
+#ifndef __TAB_NFA_H
+#define __TAB_NFA_H
+
+namespace tab {
+
+// A regex engine for the ECMAScript syntax of std::regex, with the same rules for which
+// match is found: the leftmost one, preferring alternatives and repetitions in the order
+// a backtracking matcher tries them. It runs in time linear in the length of the input.
+//
+// A pattern is compiled into a Thompson NFA. Whether a string has a match at all is
+// answered by a DFA that is built lazily from the NFA, one DFA state for each set of NFA
+// states reached, with the transitions cached. Match positions and groups come from a
+// Pike VM, which runs NFA threads in priority order and keeps the first to match.
+//
+// Syntax that needs backtracking (backreferences, lookahead) or that the parser does not
+// know falls back to std::regex. Every pattern is also checked by std::regex, so invalid
+// patterns throw the same std::regex_error as before.
+
+class Regex {
+
+    // Syntax that is valid, but that this engine leaves to std::regex.
+    struct Unsupported {};
+
+    static const size_t MAX_PROGRAM = 5000;
+    static const int MAX_REPEAT = 1000;
+    static const size_t MAX_STATES = 2048;
+
+    struct Set {
+        uint64_t bits[4];
+
+        Set() : bits{0, 0, 0, 0} {}
+
+        bool test(unsigned char c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+        void set(unsigned char c) { bits[c >> 6] |= (uint64_t)1 << (c & 63); }
+
+        void set(const Set& s) {
+            for (int i = 0; i < 4; ++i) bits[i] |= s.bits[i];
+        }
+
+        void flip() {
+            for (int i = 0; i < 4; ++i) bits[i] = ~bits[i];
+        }
+
+        size_t count() const {
+            size_t n = 0;
+            for (int i = 0; i < 4; ++i) n += __builtin_popcountll(bits[i]);
+            return n;
+        }
+    };
+
+    struct Node {
+        enum type_t { CHAR, SET, BOL, EOL, WORDB, NWORDB, CAT, ALT, GROUP, REPEAT };
+
+        type_t type;
+        int arg;
+        int min;
+        int max;
+        bool greedy;
+        std::vector<Node> sub;
+
+        Node(type_t t, int a = 0) : type(t), arg(a), min(0), max(0), greedy(true) {}
+    };
+
+    enum op_t { CHAR, SET, SPLIT, JMP, SAVE, BOL, EOL, WORDB, NWORDB, MATCH };
+
+    // SPLIT tries 'x' before 'y'.
+    struct Inst {
+        op_t op;
+        int x;
+        int y;
+    };
+
+    static bool is_word(unsigned char c) {
+        return (c == '_' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z'));
+    }
+
+    static bool is_space(unsigned char c) {
+        return (c == ' ' || (c >= '\t' && c <= '\r'));
+    }
+
+    /*** Parsing ***/
+
+    struct Parser {
+
+        const char* p;
+        const char* e;
+        std::vector<Set>& sets;
+        int ngroups;
+
+        Parser(const std::string& s, std::vector<Set>& ss) :
+            p(s.data()), e(s.data() + s.size()), sets(ss), ngroups(0) {}
+
+        bool at(char c) const { return (p != e && *p == c); }
+
+        int add_set(const Set& s) {
+            sets.push_back(s);
+            return sets.size() - 1;
+        }
+
+        // \d, \w, \s and their complements; returns false for other letters.
+        static bool class_escape(char c, Set& s) {
+
+            char lower = (c | 0x20);
+
+            if (lower != 'd' && lower != 'w' && lower != 's')
+                return false;
+
+            for (int i = 0; i < 256; ++i) {
+
+                bool in = (lower == 'd' ? (i >= '0' && i <= '9') : lower == 'w' ? is_word(i) : is_space(i));
+
+                if (in) s.set(i);
+            }
+
+            if (c != lower) s.flip();
+
+            return true;
+        }
+
+        static int char_escape(char c) {
+
+            switch (c) {
+            case 't': return '\t';
+            case 'n': return '\n';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            }
+
+            if (c != 0 && ::strchr("^$\\.*+?()[]{}|/-", c))
+                return c;
+
+            throw Unsupported();
+        }
+
+        Node parse() {
+
+            Node n = alternation();
+
+            if (p != e)
+                throw Unsupported();
+
+            return n;
+        }
+
+        Node alternation() {
+
+            Node n(Node::ALT);
+            n.sub.push_back(concatenation());
+
+            while (at('|')) {
+                ++p;
+                n.sub.push_back(concatenation());
+            }
+
+            if (n.sub.size() == 1)
+                return std::move(n.sub[0]);
+
+            return n;
+        }
+
+        Node concatenation() {
+
+            Node n(Node::CAT);
+
+            while (p != e && *p != '|' && *p != ')') {
+                n.sub.push_back(repetition());
+            }
+
+            return n;
+        }
+
+        bool number(int& n) {
+
+            if (p == e || *p < '0' || *p > '9')
+                return false;
+
+            n = 0;
+
+            while (p != e && *p >= '0' && *p <= '9') {
+
+                n = n * 10 + (*p - '0');
+
+                if (n > MAX_REPEAT)
+                    throw Unsupported();
+
+                ++p;
+            }
+
+            return true;
+        }
+
+        Node repetition() {
+
+            Node a = atom();
+
+            if (p == e)
+                return a;
+
+            int min;
+            int max;
+
+            switch (*p) {
+            case '*': min = 0; max = -1; ++p; break;
+            case '+': min = 1; max = -1; ++p; break;
+            case '?': min = 0; max = 1; ++p; break;
+            case '{':
+                ++p;
+
+                if (!number(min))
+                    throw Unsupported();
+
+                max = min;
+
+                if (at(',')) {
+                    ++p;
+
+                    if (!number(max))
+                        max = -1;
+                }
+
+                if (!at('}') || (max >= 0 && max < min))
+                    throw Unsupported();
+
+                ++p;
+                break;
+            default:
+                return a;
+            }
+
+            if (a.type == Node::BOL || a.type == Node::EOL || a.type == Node::WORDB || a.type == Node::NWORDB)
+                throw Unsupported();
+
+            Node n(Node::REPEAT);
+            n.min = min;
+            n.max = max;
+
+            if (at('?')) {
+                n.greedy = false;
+                ++p;
+            }
+
+            if (p != e && ::strchr("*+?{", *p))
+                throw Unsupported();
+
+            // How many times a backtracking matcher lets a repetition match the empty
+            // string differs between implementations.
+            if (nullable(a) && (max < 0 || has_group(a)))
+                throw Unsupported();
+
+            n.sub.push_back(std::move(a));
+            return n;
+        }
+
+        Node atom() {
+
+            char c = *p;
+            ++p;
+
+            switch (c) {
+            case '^':
+                return Node(Node::BOL);
+
+            case '$':
+                return Node(Node::EOL);
+
+            case '.': {
+                Set s;
+                s.set('\n');
+                s.set('\r');
+                s.flip();
+                return Node(Node::SET, add_set(s));
+            }
+
+            case '[':
+                return bracket();
+
+            case '(': {
+                int group = -1;
+
+                if (at('?')) {
+                    ++p;
+
+                    if (!at(':'))
+                        throw Unsupported();
+
+                    ++p;
+
+                } else {
+                    group = ++ngroups;
+                }
+
+                Node n(Node::GROUP, group);
+                n.sub.push_back(alternation());
+
+                if (!at(')'))
+                    throw Unsupported();
+
+                ++p;
+                return n;
+            }
+
+            case '\\': {
+                if (p == e)
+                    throw Unsupported();
+
+                c = *p;
+                ++p;
+
+                if (c == 'b')
+                    return Node(Node::WORDB);
+
+                if (c == 'B')
+                    return Node(Node::NWORDB);
+
+                Set s;
+
+                if (class_escape(c, s))
+                    return Node(Node::SET, add_set(s));
+
+                return Node(Node::CHAR, char_escape(c));
+            }
+
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+            case '}':
+            case ']':
+            case ')':
+                throw Unsupported();
+            }
+
+            return Node(Node::CHAR, (unsigned char)c);
+        }
+
+        // One character of a bracket expression; returns false for a class like \d,
+        // which is added to 's' and cannot end a range.
+        bool bracket_char(int& c, Set& s) {
+
+            if (p == e)
+                throw Unsupported();
+
+            c = (unsigned char)*p;
+            ++p;
+
+            if (c == '[' && p != e && (*p == ':' || *p == '.' || *p == '='))
+                throw Unsupported();
+
+            if (c != '\\')
+                return true;
+
+            if (p == e)
+                throw Unsupported();
+
+            char x = *p;
+            ++p;
+
+            if (class_escape(x, s))
+                return false;
+
+            c = char_escape(x);
+            return true;
+        }
+
+        Node bracket() {
+
+            Set s;
+            bool negate = false;
+
+            if (at('^')) {
+                negate = true;
+                ++p;
+            }
+
+            if (at(']'))
+                throw Unsupported();
+
+            while (!at(']')) {
+
+                int lo;
+
+                if (!bracket_char(lo, s)) {
+
+                    if (at('-') && p + 1 != e && p[1] != ']')
+                        throw Unsupported();
+
+                    continue;
+                }
+
+                if (at('-') && p + 1 != e && p[1] != ']') {
+                    ++p;
+
+                    int hi;
+
+                    if (!bracket_char(hi, s) || lo > hi || hi >= 0x80)
+                        throw Unsupported();
+
+                    for (int i = lo; i <= hi; ++i) {
+                        s.set(i);
+                    }
+
+                } else {
+                    s.set(lo);
+                }
+            }
+
+            ++p;
+
+            if (negate) s.flip();
+
+            return Node(Node::SET, add_set(s));
+        }
+
+        static bool nullable(const Node& n) {
+
+            switch (n.type) {
+            case Node::CHAR:
+            case Node::SET:
+                return false;
+            case Node::CAT:
+                for (const Node& s : n.sub) {
+                    if (!nullable(s)) return false;
+                }
+                return true;
+            case Node::ALT:
+                for (const Node& s : n.sub) {
+                    if (nullable(s)) return true;
+                }
+                return false;
+            case Node::GROUP:
+                return nullable(n.sub[0]);
+            case Node::REPEAT:
+                return (n.min == 0 || nullable(n.sub[0]));
+            default:
+                return true;
+            }
+        }
+
+        static bool has_group(const Node& n) {
+
+            if (n.type == Node::GROUP && n.arg >= 0)
+                return true;
+
+            for (const Node& s : n.sub) {
+                if (has_group(s)) return true;
+            }
+
+            return false;
+        }
+    };
+
+    /*** Compiling ***/
+
+    int emit(op_t op, int x = 0, int y = 0) {
+
+        if (prog.size() >= MAX_PROGRAM)
+            throw Unsupported();
+
+        prog.push_back(Inst{op, x, y});
+        return prog.size() - 1;
+    }
+
+    void compile(const Node& n) {
+
+        switch (n.type) {
+        case Node::CHAR:
+            emit(CHAR, n.arg);
+            break;
+        case Node::SET:
+            emit(SET, n.arg);
+            break;
+        case Node::BOL:
+            emit(BOL);
+            break;
+        case Node::EOL:
+            emit(EOL);
+            break;
+        case Node::WORDB:
+            emit(WORDB);
+            break;
+        case Node::NWORDB:
+            emit(NWORDB);
+            break;
+
+        case Node::CAT:
+            for (const Node& s : n.sub) {
+                compile(s);
+            }
+            break;
+
+        case Node::ALT: {
+            std::vector<int> jumps;
+
+            for (size_t i = 0; i + 1 < n.sub.size(); ++i) {
+                int split = emit(SPLIT);
+                prog[split].x = prog.size();
+                compile(n.sub[i]);
+                jumps.push_back(emit(JMP));
+                prog[split].y = prog.size();
+            }
+
+            compile(n.sub.back());
+
+            for (int j : jumps) {
+                prog[j].x = prog.size();
+            }
+            break;
+        }
+
+        case Node::GROUP:
+            if (n.arg >= 0) emit(SAVE, 2 * n.arg);
+            compile(n.sub[0]);
+            if (n.arg >= 0) emit(SAVE, 2 * n.arg + 1);
+            break;
+
+        case Node::REPEAT: {
+            for (int i = 0; i < n.min; ++i) {
+                compile(n.sub[0]);
+            }
+
+            if (n.max < 0) {
+                int split = emit(SPLIT);
+                compile(n.sub[0]);
+                emit(JMP, split);
+                branch(split, split + 1, prog.size(), n.greedy);
+                break;
+            }
+
+            std::vector<int> splits;
+
+            for (int i = n.min; i < n.max; ++i) {
+                splits.push_back(emit(SPLIT));
+                compile(n.sub[0]);
+            }
+
+            for (int s : splits) {
+                branch(s, s + 1, prog.size(), n.greedy);
+            }
+            break;
+        }
+        }
+    }
+
+    void branch(int split, int more, int done, bool greedy) {
+        prog[split].x = (greedy ? more : done);
+        prog[split].y = (greedy ? done : more);
+    }
+
+    bool accepts(const Inst& in, unsigned char c) const {
+        return (in.op == CHAR ? in.x == c : in.op == SET && sets[in.x].test(c));
+    }
+
+    /*** The Pike VM ***/
+
+    enum cond_t { IF_BOL = 1, IF_EOL = 2, IF_WORDB = 4, IF_NWORDB = 8 };
+
+    // The epsilon closure of an instruction, flattened: each instruction that consumes a
+    // byte (or MATCH) reached without consuming input, in priority order, with the
+    // assertions on the way and the range of the groups saved on the way in 'saves'.
+    struct Follow {
+        int pc;
+        unsigned int cond;
+        unsigned int save_b;
+        unsigned int save_e;
+    };
+
+    static const size_t MAX_FOLLOWS = 1 << 20;
+
+    std::vector<Follow> follows;
+    std::vector<int> saves;
+    std::vector< std::pair<unsigned int, unsigned int> > follow_range;
+
+    // Paths that reach an instruction with the same assertions are the same path for
+    // the VM: the first one, in priority order, wins.
+    void flatten(int pc, unsigned int cond, std::vector<int>& path, std::vector<uint16_t>& visited) {
+
+        if ((cond & IF_WORDB) && (cond & IF_NWORDB))
+            return;
+
+        if (visited[pc] & (1 << cond))
+            return;
+
+        visited[pc] |= (1 << cond);
+
+        const Inst& in = prog[pc];
+
+        switch (in.op) {
+        case JMP:
+            flatten(in.x, cond, path, visited);
+            break;
+        case SPLIT:
+            flatten(in.x, cond, path, visited);
+            flatten(in.y, cond, path, visited);
+            break;
+        case SAVE:
+            path.push_back(in.x);
+            flatten(pc + 1, cond, path, visited);
+            path.pop_back();
+            break;
+        case BOL:
+            flatten(pc + 1, cond | IF_BOL, path, visited);
+            break;
+        case EOL:
+            flatten(pc + 1, cond | IF_EOL, path, visited);
+            break;
+        case WORDB:
+            flatten(pc + 1, cond | IF_WORDB, path, visited);
+            break;
+        case NWORDB:
+            flatten(pc + 1, cond | IF_NWORDB, path, visited);
+            break;
+        default:
+            if (follows.size() >= MAX_FOLLOWS)
+                throw Unsupported();
+
+            follows.push_back(Follow{pc, cond, (unsigned int)saves.size(), (unsigned int)(saves.size() + path.size())});
+            saves.insert(saves.end(), path.begin(), path.end());
+            break;
+        }
+    }
+
+    void flatten_all() {
+
+        follow_range.resize(prog.size());
+
+        std::vector<int> path;
+        std::vector<uint16_t> visited(prog.size());
+
+        for (size_t pc = 0; pc < prog.size(); ++pc) {
+
+            // Threads start at 0, or continue after a byte is consumed.
+            if (pc != 0 && prog[pc - 1].op != CHAR && prog[pc - 1].op != SET)
+                continue;
+
+            std::fill(visited.begin(), visited.end(), 0);
+
+            follow_range[pc].first = follows.size();
+            flatten(pc, 0, path, visited);
+            follow_range[pc].second = follows.size();
+        }
+    }
+
+    // There is at most one thread for each instruction.
+    struct Threads {
+        std::vector<int> pc;
+        std::vector<const char*> caps;
+        size_t ncap;
+        size_t n;
+
+        void init(size_t nprog, size_t nc) {
+            ncap = nc;
+            n = 0;
+            pc.resize(nprog);
+            caps.resize(nprog * nc);
+        }
+
+        void clear() { n = 0; }
+
+        const char** at(size_t i) { return &caps[i * ncap]; }
+    };
+
+    // Text boundaries of the current search, for the assertions.
+    const char* text_b;
+    const char* text_e;
+    bool text_prev;
+
+    bool boundary(const char* p) const {
+
+        bool left = ((p != text_b || text_prev) && is_word(p[-1]));
+        bool right = (p != text_e && is_word(*p));
+
+        return (left != right);
+    }
+
+    bool holds(unsigned int cond, const char* p) const {
+
+        if ((cond & IF_BOL) && (p != text_b || text_prev)) return false;
+        if ((cond & IF_EOL) && p != text_e) return false;
+        if ((cond & IF_WORDB) && !boundary(p)) return false;
+        if ((cond & IF_NWORDB) && boundary(p)) return false;
+
+        return true;
+    }
+
+    // Adds the threads that follow 'pc' to 'l'; only the first thread to reach an
+    // instruction is kept.
+    void add(Threads& l, int pc, const char* p, const char** caps) {
+
+        const std::pair<unsigned int, unsigned int>& r = follow_range[pc];
+
+        for (unsigned int i = r.first; i < r.second; ++i) {
+
+            const Follow& f = follows[i];
+
+            if (seen[f.pc] == stamp || (f.cond && !holds(f.cond, p)))
+                continue;
+
+            seen[f.pc] = stamp;
+
+            const char** c = l.at(l.n);
+            std::copy(caps, caps + l.ncap, c);
+
+            for (unsigned int j = f.save_b; j < f.save_e; ++j) {
+                c[saves[j]] = p;
+            }
+
+            l.pc[l.n] = f.pc;
+            ++l.n;
+        }
+    }
+
+    // Skips to the next byte that can start a match, when no match is in progress.
+    const char* skip(const char* p, const char* e) const {
+
+        if (first_count == 1) {
+            const char* q = (const char*)::memchr(p, first_byte, e - p);
+            return (q ? q : e);
+        }
+
+        while (p != e && !first.test(*p))
+            ++p;
+
+        return p;
+    }
+
+    bool pike(const char* b, const char* e, bool prev, bool not_null, bool continuous) {
+
+        text_b = b;
+        text_e = e;
+        text_prev = prev;
+
+        Threads* cl = &clist;
+        Threads* nl = &nlist;
+        cl->clear();
+
+        std::fill(blank.begin(), blank.end(), nullptr);
+
+        bool matched = false;
+        const char* p = b;
+        next_stamp();
+
+        while (1) {
+
+            if (!matched && (!continuous || p == b)) {
+
+                if (cl->n == 0 && can_skip && (p != b || prev) && !continuous) {
+
+                    const char* q = skip(p, e);
+
+                    if (q != p) {
+                        p = q;
+                        next_stamp();
+                    }
+
+                    if (p == e)
+                        break;
+                }
+
+                add(*cl, 0, p, blank.data());
+            }
+
+            if (cl->n == 0 && (matched || continuous || p == e))
+                break;
+
+            next_stamp();
+            nl->clear();
+
+            for (size_t i = 0; i < cl->n; ++i) {
+
+                const Inst& in = prog[cl->pc[i]];
+                const char** caps = cl->at(i);
+
+                if (in.op == MATCH) {
+
+                    if (not_null && caps[0] == p)
+                        continue;
+
+                    std::copy(caps, caps + match.size(), match.begin());
+                    matched = true;
+
+                    // Threads of lower priority cannot give the match any more.
+                    break;
+                }
+
+                if (p != e && accepts(in, *p))
+                    add(*nl, cl->pc[i] + 1, p + 1, caps);
+            }
+
+            std::swap(cl, nl);
+
+            if (p == e)
+                break;
+
+            ++p;
+        }
+
+        return matched;
+    }
+
+    /*** The lazy DFA ***/
+
+    struct DState {
+        std::vector<int> pcs;
+        bool match;
+        int next[256];
+    };
+
+    std::vector<DState> dstates;
+    std::map<std::vector<int>, int> dindex;
+    std::vector<int> dtmp;
+    int dstart[2];
+    int dreseed;
+
+    // The consuming instructions, MATCH and unresolved EOL assertions reached from 'pc'.
+    void closure(int pc, bool bol, bool eol, std::vector<int>& out) {
+
+        if (seen[pc] == stamp)
+            return;
+
+        seen[pc] = stamp;
+
+        const Inst& in = prog[pc];
+
+        switch (in.op) {
+        case JMP:
+            closure(in.x, bol, eol, out);
+            break;
+        case SPLIT:
+            closure(in.x, bol, eol, out);
+            closure(in.y, bol, eol, out);
+            break;
+        case SAVE:
+            closure(pc + 1, bol, eol, out);
+            break;
+        case BOL:
+            if (bol) closure(pc + 1, bol, eol, out);
+            break;
+        case EOL:
+            if (eol)
+                closure(pc + 1, bol, eol, out);
+            else
+                out.push_back(pc);
+            break;
+        default:
+            out.push_back(pc);
+            break;
+        }
+    }
+
+    int dstate(std::vector<int>& pcs) {
+
+        std::sort(pcs.begin(), pcs.end());
+
+        auto i = dindex.find(pcs);
+
+        if (i != dindex.end())
+            return i->second;
+
+        dstates.emplace_back();
+        DState& s = dstates.back();
+        s.pcs = pcs;
+        s.match = std::binary_search(pcs.begin(), pcs.end(), (int)prog.size() - 1);
+        std::fill(s.next, s.next + 256, -1);
+
+        dindex.insert(std::make_pair(pcs, dstates.size() - 1));
+        return dstates.size() - 1;
+    }
+
+    void dstart_states() {
+
+        dstates.clear();
+        dindex.clear();
+
+        for (int bol = 0; bol < 2; ++bol) {
+            dtmp.clear();
+            next_stamp();
+            closure(0, bol, false, dtmp);
+            dstart[bol] = dstate(dtmp);
+        }
+
+        dreseed = dstart[0];
+    }
+
+    int dnext(int s, unsigned char c) {
+
+        if (dstates.size() >= MAX_STATES) {
+            std::vector<int> pcs = dstates[s].pcs;
+            dstart_states();
+            s = dstate(pcs);
+        }
+
+        dtmp.clear();
+        next_stamp();
+
+        for (int pc : dstates[s].pcs) {
+            if (accepts(prog[pc], c))
+                closure(pc + 1, false, false, dtmp);
+        }
+
+        // A match may also start at the next position.
+        closure(0, false, false, dtmp);
+
+        int n = dstate(dtmp);
+        dstates[s].next[c] = n;
+        return n;
+    }
+
+    bool dmatch_at_end(int s, bool bol) {
+
+        dtmp.clear();
+        next_stamp();
+
+        for (int pc : dstates[s].pcs) {
+            if (prog[pc].op == EOL)
+                closure(pc + 1, bol, true, dtmp);
+        }
+
+        return (std::find(dtmp.begin(), dtmp.end(), (int)prog.size() - 1) != dtmp.end());
+    }
+
+    bool dfa(const char* b, const char* e, bool prev) {
+
+        if (dstates.empty())
+            dstart_states();
+
+        int s = dstart[prev ? 0 : 1];
+        const char* p = b;
+
+        while (p != e) {
+
+            if (dstates[s].match)
+                return true;
+
+            if (s == dreseed && can_skip) {
+                p = skip(p, e);
+
+                if (p == e) break;
+            }
+
+            unsigned char c = *p;
+            int n = dstates[s].next[c];
+
+            s = (n >= 0 ? n : dnext(s, c));
+            ++p;
+        }
+
+        return (dstates[s].match || dmatch_at_end(s, p == b && !prev));
+    }
+
+    /*** State ***/
+
+    std::unique_ptr<std::regex> fallback;
+
+    std::vector<Inst> prog;
+    std::vector<Set> sets;
+    bool has_boundary;
+
+    // The bytes that can start a match away from the start of the text.
+    Set first;
+    size_t first_count;
+    unsigned char first_byte;
+    bool can_skip;
+
+    std::vector<unsigned int> seen;
+    unsigned int stamp;
+    Threads clist;
+    Threads nlist;
+    std::vector<const char*> blank;
+
+    void next_stamp() {
+
+        if (++stamp == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    void init_first() {
+
+        std::vector<int> pcs;
+        next_stamp();
+        closure(0, false, false, pcs);
+
+        can_skip = true;
+
+        for (int pc : pcs) {
+
+            const Inst& in = prog[pc];
+
+            if (in.op == CHAR) {
+                first.set((unsigned char)in.x);
+
+            } else if (in.op == SET) {
+                first.set(sets[in.x]);
+
+            } else {
+                can_skip = false;
+            }
+        }
+
+        if (has_boundary)
+            can_skip = false;
+
+        first_count = first.count();
+
+        for (int i = 0; i < 256; ++i) {
+            if (first.test(i)) first_byte = i;
+        }
+    }
+
+public:
+
+    // Begin and end of the match and of each group; nullptr for groups that did not match.
+    std::vector<const char*> match;
+
+    Regex(const std::string& pattern) : stamp(0) {
+
+        fallback.reset(new std::regex(pattern, std::regex_constants::optimize));
+
+        size_t ngroups = fallback->mark_count();
+
+        match.resize(2 * (ngroups + 1));
+
+        try {
+            Parser parser(pattern, sets);
+            Node root = parser.parse();
+
+            if ((size_t)parser.ngroups != ngroups)
+                throw Unsupported();
+
+            emit(SAVE, 0);
+            compile(root);
+            emit(SAVE, 1);
+            emit(MATCH);
+
+            flatten_all();
+
+        } catch (Unsupported& u) {
+            prog.clear();
+            sets.clear();
+            follows.clear();
+            saves.clear();
+            follow_range.clear();
+            return;
+        }
+
+        fallback.reset();
+
+        has_boundary = false;
+
+        for (const Inst& in : prog) {
+            if (in.op == WORDB || in.op == NWORDB) has_boundary = true;
+        }
+
+        blank.resize(match.size());
+        seen.resize(prog.size());
+        clist.init(prog.size(), match.size());
+        nlist.init(prog.size(), match.size());
+
+        init_first();
+    }
+
+    // The number of groups, counting the whole match as group 0.
+    size_t groups() const { return match.size() / 2; }
+
+    // Finds the leftmost match in [b, e) and stores it in 'match'. The flags are those of
+    // std::regex_search: with 'prev', b[-1] is part of the text, so '^' does not match at
+    // 'b' and '\b' looks at it; 'not_null' skips empty matches; with 'continuous', only a
+    // match that begins at 'b' is found.
+    bool search(const char* b, const char* e, bool prev = false, bool not_null = false, bool continuous = false) {
+
+        if (!fallback)
+            return pike(b, e, prev, not_null, continuous);
+
+        std::regex_constants::match_flag_type flags = std::regex_constants::match_default;
+
+        if (prev) flags |= std::regex_constants::match_prev_avail;
+        if (not_null) flags |= std::regex_constants::match_not_null;
+        if (continuous) flags |= std::regex_constants::match_continuous;
+
+        std::cmatch m;
+
+        if (!std::regex_search(b, e, m, *fallback, flags))
+            return false;
+
+        for (size_t i = 0; i < m.size(); ++i) {
+            match[2 * i] = (m[i].matched ? m[i].first : nullptr);
+            match[2 * i + 1] = (m[i].matched ? m[i].second : nullptr);
+        }
+
+        return true;
+    }
+
+    // Whether [b, e) has a match, without finding where it is.
+    bool contains(const char* b, const char* e) {
+
+        if (fallback)
+            return std::regex_search(b, e, *fallback);
+
+        if (has_boundary)
+            return pike(b, e, false, false, false);
+
+        return dfa(b, e, false);
+    }
+
+    // Calls f() after each match is found, in the order of std::regex_iterator: after an
+    // empty match, a non-empty match at the same position is tried before moving on.
+    template <typename F>
+    void each(const char* b, const char* e, F f) {
+
+        if (!contains(b, e) || !search(b, e))
+            return;
+
+        bool prev = false;
+
+        while (1) {
+
+            f();
+
+            const char* p = match[1];
+
+            if (match[0] == p) {
+
+                if (p == e)
+                    return;
+
+                if (search(p, e, prev, true, true))
+                    continue;
+
+                ++p;
+            }
+
+            prev = true;
+
+            if (!search(p, e, true))
+                return;
+        }
+    }
+};
+
+} // namespace tab
+
+#endif
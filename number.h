@@ -0,0 +1,361 @@
+#ifndef __TAB_NUMBER_H
+#define __TAB_NUMBER_H
+
+namespace tab {
+
+// Hand-written number formatting for output, without going through printf().
+// Every function writes into 'out', which must have at least NUMBER_SPACE bytes,
+// and returns the number of bytes written.
+
+static const size_t NUMBER_SPACE = 32;
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline size_t format_uint(UInt v, char* out) {
+
+    char tmp[NUMBER_SPACE];
+    char* e = tmp + NUMBER_SPACE;
+    char* p = e;
+
+    while (v >= 100) {
+        UInt i = (v % 100) * 2;
+        v /= 100;
+        p -= 2;
+        p[0] = digit_pairs[i];
+        p[1] = digit_pairs[i + 1];
+    }
+
+    if (v >= 10) {
+        p -= 2;
+        p[0] = digit_pairs[v * 2];
+        p[1] = digit_pairs[v * 2 + 1];
+    } else {
+        *(--p) = '0' + v;
+    }
+
+    size_t n = e - p;
+    ::memcpy(out, p, n);
+    return n;
+}
+
+inline size_t format_int(Int v, char* out) {
+
+    if (v < 0) {
+        *out = '-';
+        // Negate in unsigned arithmetic so that the smallest Int does not overflow.
+        return 1 + format_uint(-(UInt)v, out + 1);
+    }
+
+    return format_uint(v, out);
+}
+
+inline size_t format_hex(UInt v, char* out) {
+
+    static const char digits[] = "0123456789ABCDEF";
+
+    char tmp[NUMBER_SPACE];
+    char* e = tmp + NUMBER_SPACE;
+    char* p = e;
+
+    do {
+        *(--p) = digits[v & 0xF];
+        v >>= 4;
+    } while (v);
+
+    out[0] = '0';
+    out[1] = 'x';
+
+    size_t n = e - p;
+    ::memcpy(out + 2, p, n);
+    return n + 2;
+}
+
+// Formats exactly like printf("%g"): six significant digits, trailing zeros removed.
+// The common case of numbers printed without an exponent is done here; anything
+// that could round differently from printf() is handed to snprintf().
+inline size_t format_real(Real v, char* out) {
+
+    static const Real pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+    Real a = (v < 0 ? -v : v);
+
+    if (a >= 1e-4 && a < 1e6) {
+
+        char* p = out;
+
+        if (v < 0) {
+            *p++ = '-';
+        }
+
+        if (a == (Real)(UInt)a) {
+            return (p - out) + format_uint((UInt)a, p);
+        }
+
+        // The decimal exponent: a is in [10^e, 10^(e+1)).
+        int e = 5;
+
+        while (e > -4 && a < pow10[e + 4] / 1e4) {
+            --e;
+        }
+
+        Real scaled = a * pow10[5 - e];
+        Real fl = ::floor(scaled);
+        Real frac = scaled - fl;
+
+        if (::fabs(frac - 0.5) > 1e-6) {
+
+            UInt r = (UInt)fl + (frac > 0.5 ? 1 : 0);
+
+            if (r >= 1000000) {
+                r /= 10;
+                ++e;
+            }
+
+            if (e < 6) {
+
+                char digits[NUMBER_SPACE];
+                format_uint(r, digits);
+
+                // Six digits; drop the trailing zeros of the fraction.
+                int nd = 6;
+
+                while (nd > e + 1 && nd > 0 && digits[nd - 1] == '0') {
+                    --nd;
+                }
+
+                if (e >= 0) {
+                    ::memcpy(p, digits, e + 1);
+                    p += e + 1;
+
+                    if (nd > e + 1) {
+                        *p++ = '.';
+                        ::memcpy(p, digits + e + 1, nd - e - 1);
+                        p += nd - e - 1;
+                    }
+
+                } else {
+                    *p++ = '0';
+                    *p++ = '.';
+
+                    for (int i = -1; i > e; --i) {
+                        *p++ = '0';
+                    }
+
+                    ::memcpy(p, digits, nd);
+                    p += nd;
+                }
+
+                return p - out;
+            }
+        }
+    }
+
+    return ::snprintf(out, NUMBER_SPACE, "%g", v);
+}
+
+// Hand-written number parsing for input, without the locale, the string copies and the
+// exceptions of std::stol() and friends. Every function parses a number that starts
+// at 'b' and must end at or before 'e', and returns the end of the number, or nullptr
+// if there is no number or it does not fit into the result type.
+
+// Parses the sign and the magnitude of an integer. With 'base' 0 the base is picked
+// like strtol() does: '0x' for hex, a leading '0' for octal, otherwise decimal.
+inline const char* parse_magnitude(const char* p, const char* e, int base, bool& neg, UInt& out) {
+
+    while (p != e && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) {
+        ++p;
+    }
+
+    neg = false;
+
+    if (p != e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    if ((base == 0 || base == 16) && e - p >= 3 && p[0] == '0' && (p[1] | 0x20) == 'x' &&
+        ((p[2] >= '0' && p[2] <= '9') || ((p[2] | 0x20) >= 'a' && (p[2] | 0x20) <= 'f'))) {
+        base = 16;
+        p += 2;
+
+    } else if (base == 0) {
+        base = (p != e && *p == '0' ? 8 : 10);
+    }
+
+    const char* start = p;
+    bool overflow = false;
+    UInt v = 0;
+
+    for (; p != e; ++p) {
+
+        unsigned int d = (unsigned char)*p - '0';
+
+        if (d > 9) {
+            unsigned int letter = ((unsigned char)*p | 0x20) - 'a';
+            d = (letter < 26 ? letter + 10 : 36);
+        }
+
+        if (d >= (unsigned int)base) break;
+
+        overflow |= __builtin_mul_overflow(v, (UInt)base, &v);
+        overflow |= __builtin_add_overflow(v, (UInt)d, &v);
+    }
+
+    if (p == start || overflow)
+        return nullptr;
+
+    out = v;
+    return p;
+}
+
+// Accepts what std::stol(s, 0, base) accepts.
+inline const char* parse_int(const char* b, const char* e, Int& out, int base = 0) {
+
+    bool neg;
+    UInt v;
+
+    const char* p = parse_magnitude(b, e, base, neg, v);
+
+    if (!p)
+        return nullptr;
+
+    if (v > (UInt)std::numeric_limits<Int>::max() + (neg ? 1 : 0))
+        return nullptr;
+
+    out = (neg ? (Int)(0 - v) : (Int)v);
+    return p;
+}
+
+// Accepts what std::stoul(s, 0, base) accepts; like it, a negative number wraps around.
+inline const char* parse_uint(const char* b, const char* e, UInt& out, int base = 0) {
+
+    bool neg;
+    UInt v;
+
+    const char* p = parse_magnitude(b, e, base, neg, v);
+
+    if (!p)
+        return nullptr;
+
+    out = (neg ? 0 - v : v);
+    return p;
+}
+
+// Accepts what std::stod() accepts. Decimal numbers with at most 19 significant digits
+// and a small exponent are converted exactly with one multiplication or division of
+// two doubles (Clinger's fast path); the rest is handed to strtod().
+inline const char* parse_real(const char* b, const char* e, Real& out) {
+
+    static const Real pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    static const UInt max_exact = (UInt)1 << 53;
+
+    const char* p = b;
+
+    while (p != e && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) {
+        ++p;
+    }
+
+    bool neg = false;
+
+    if (p != e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    UInt w = 0;
+    int ndigits = 0;
+    int nsignificant = 0;
+    int exp = 0;
+
+    for (; p != e && *p >= '0' && *p <= '9'; ++p) {
+        nsignificant += ((w != 0 || *p != '0') && nsignificant < 20);
+        w = w * 10 + (*p - '0');
+        ++ndigits;
+    }
+
+    if (p != e && *p == '.') {
+
+        for (++p; p != e && *p >= '0' && *p <= '9'; ++p) {
+            nsignificant += ((w != 0 || *p != '0') && nsignificant < 20);
+            w = w * 10 + (*p - '0');
+            ++ndigits;
+            --exp;
+        }
+    }
+
+    // Hex floats, infinities, NaNs and too many digits for the fast path.
+    bool slow = (ndigits == 0 || nsignificant > 19 || (p != e && (*p | 0x20) == 'x'));
+
+    if (!slow && p != e && (*p | 0x20) == 'e') {
+
+        const char* q = p + 1;
+        bool eneg = false;
+
+        if (q != e && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            ++q;
+        }
+
+        if (q != e && *q >= '0' && *q <= '9') {
+
+            int x = 0;
+
+            for (; q != e && *q >= '0' && *q <= '9'; ++q) {
+                if (x < 100000) x = x * 10 + (*q - '0');
+            }
+
+            exp += (eneg ? -x : x);
+            p = q;
+        }
+    }
+
+    if (!slow) {
+
+        // Moves powers of ten from a large exponent into the mantissa while it stays exact.
+        while (exp > 22 && w != 0 && w * 10 <= max_exact) {
+            w *= 10;
+            --exp;
+        }
+
+        if (w == 0) {
+            out = (neg ? -0.0 : 0.0);
+            return p;
+        }
+
+        if (w <= max_exact && exp >= -22 && exp <= 22) {
+            Real v = (exp < 0 ? (Real)w / pow10[-exp] : (Real)w * pow10[exp]);
+            out = (neg ? -v : v);
+            return p;
+        }
+    }
+
+    std::string tmp(b, e);
+    char* end;
+
+    errno = 0;
+    Real v = ::strtod(tmp.c_str(), &end);
+
+    if (end == tmp.c_str() || errno == ERANGE)
+        return nullptr;
+
+    out = v;
+    return b + (end - tmp.c_str());
+}
+
+} // namespace tab
+
+#endif
@@ -5,48 +5,70 @@ namespace tab {
 
 namespace obj {
 
+// Output is formatted into a large buffer, which is written out when it fills up at the end
+// of a line, or at every line when stdout is a terminal.
 struct Printer {
 
     bool null;
+    std::string buf;
+    char tmp[NUMBER_SPACE];
+
+    static const size_t BUFSIZE = 64*1024;
+
     Printer() : null(true) {}
 
+    virtual ~Printer() { flush(); }
+
+    static bool& line_buffered() {
+        static bool ret = ::isatty(1);
+        return ret;
+    }
+
     void bump() { null = false; }
 
-    virtual void val(tab::UInt v) { bump(); printf("%lu", v); }
-    virtual void val(tab::Int v)  { bump(); printf("%ld", v); }
-    virtual void val(tab::Real v) { bump(); printf("%g", v); }
-    virtual void hex(tab::UInt v) { bump(); printf("0x%lX", v); }
+    void flush() {
+        if (!buf.empty()) {
+            fwrite(buf.data(), sizeof(char), buf.size(), stdout);
+            buf.clear();
+        }
+    }
+
+    virtual void val(tab::UInt v) { bump(); buf.append(tmp, format_uint(v, tmp)); }
+    virtual void val(tab::Int v)  { bump(); buf.append(tmp, format_int(v, tmp)); }
+    virtual void val(tab::Real v) { bump(); buf.append(tmp, format_real(v, tmp)); }
+    virtual void hex(tab::UInt v) { bump(); buf.append(tmp, format_hex(v, tmp)); }
 
     virtual void val(const std::string& v) {
         bump();
-        fwrite(v.data(), sizeof(char), v.size(), stdout);
+        buf += v;
+
+        if (buf.size() >= BUFSIZE) {
+            flush();
+        }
     }
 
-    virtual void rs() { bump(); printf("\t"); }
-    virtual void nl() { bump(); printf("\n"); }
-    virtual void alts() { bump(); printf(";"); }
+    virtual void rs() { bump(); buf += '\t'; }
+    virtual void alts() { bump(); buf += ';'; }
+
+    virtual void nl() {
+        bump();
+        buf += '\n';
+
+        if (buf.size() >= BUFSIZE || line_buffered()) {
+            flush();
+        }
+    }
 };
 
 template <bool COMPACT=false>
 struct PrinterStr : public Printer {
     std::string buff;
-    static const size_t SPACE = 64;
-    char tmp[SPACE];
-
-    template <typename V>
-    void val_(const char* format, V v) {
-        int n = snprintf(tmp, SPACE, format, v);
-        if ((size_t)n >= SPACE) {
-            throw std::runtime_error("snprintf overflow sanity error.");
-        }
-        buff += tmp;
-    }
 
-    virtual void val(tab::UInt v) { val_("%lu", v); }
-    virtual void val(tab::Int v)  { val_("%ld", v); }
-    virtual void val(tab::Real v) { val_("%g", v); }
+    virtual void val(tab::UInt v) { buff.append(tmp, format_uint(v, tmp)); }
+    virtual void val(tab::Int v)  { buff.append(tmp, format_int(v, tmp)); }
+    virtual void val(tab::Real v) { buff.append(tmp, format_real(v, tmp)); }
     virtual void val(const std::string& v) { buff += v; }
-    virtual void hex(tab::UInt v) { val_("0x%lX", v); }
+    virtual void hex(tab::UInt v) { buff.append(tmp, format_hex(v, tmp)); }
     virtual void rs() { if (!COMPACT) { buff += "\t"; } }
     virtual void nl() { buff += "\n"; }
     virtual void alts() { buff += ";"; }
@@ -82,6 +104,19 @@ struct Object {
     
     virtual Object* next() { throw std::runtime_error("Object 'next' operator not implemented"); }
 
+    // Skips up to n elements of a sequence and returns how many were skipped.
+    // Sequences that can seek (e.g. indexed input files) override this.
+    virtual UInt skip(UInt n) {
+
+        UInt i = 0;
+
+        while (i < n && next()) {
+            ++i;
+        }
+
+        return i;
+    }
+
     virtual void merge(const Object*) {}
     virtual void merge_end() {}
 };
@@ -114,6 +149,30 @@ typedef Atom<tab::UInt> UInt;
 typedef Atom<tab::Real> Real;
 typedef Atom<std::string> String;
 
+// A string that points into a buffer owned by someone else, e.g. a field cut from the
+// current line. It compares and hashes like a String and becomes one when cloned.
+// Only values that are consumed immediately are made into views; see optimize().
+struct StringView : public Object {
+    const char* b;
+    const char* e;
+
+    StringView() : b(nullptr), e(nullptr) {}
+
+    hash_t hash() const { return do_hash((const unsigned char*)b, e - b, fnv_basis(), fnv_prime()); }
+
+    bool eq(Object* a) const {
+        const std::string& s = get<String>(a).v;
+        return s.size() == (size_t)(e - b) && ::memcmp(s.data(), b, e - b) == 0;
+    }
+
+    void print(Printer& p) { p.val(std::string(b, e)); }
+    Object* clone() const { return new String(std::string(b, e)); }
+};
+
+Object* make_view() {
+    return new StringView;
+}
+
 
 template <typename T>
 struct ArrayAtom : public Object {
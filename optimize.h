@@ -69,6 +69,188 @@ void remove_variable(std::vector<Command>& commands, size_t var) {
     commands.swap(ret);
 }
 
+void fuse_functions(std::vector<Command>& commands) {
+
+    for (auto& cmd : commands) {
+
+        for (auto& j : cmd.closure) {
+            fuse_functions(j.code);
+        }
+    }
+
+    std::vector<Command> ret;
+    ret.reserve(commands.size());
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+
+        auto& cmd = commands[i];
+
+        if (i + 1 < commands.size() && cmd.cmd == Command::FUN && commands[i + 1].cmd == Command::FUN &&
+            cmd.object == nullptr && commands[i + 1].object == nullptr) {
+
+            auto& next = commands[i + 1];
+
+            Functions::func_t f = functions().fused((Functions::func_t)cmd.function, (Functions::func_t)next.function);
+
+            if (f) {
+                // The fused call keeps the name of the first function, and the type of the second.
+                ret.push_back(cmd);
+                ret.back().function = (void*)f;
+                ret.back().type = next.type;
+                ++i;
+                continue;
+            }
+        }
+
+        ret.push_back(cmd);
+    }
+
+    commands.swap(ret);
+}
+
+// Finds the command that consumes the result of commands[i], and which of its arguments
+// the result is. Returns false if the result goes anywhere else, or if anything in between
+// could reuse the string it was computed from.
+bool find_consumer(const std::vector<Command>& commands, size_t i, size_t& consumer, size_t& arg) {
+
+    size_t depth = 0;
+
+    for (size_t j = i + 1; j < commands.size(); ++j) {
+
+        const Command& cmd = commands[j];
+
+        if (!cmd.closure.empty())
+            return false;
+
+        switch (cmd.cmd) {
+
+        case Command::VAL:
+        case Command::FUN0:
+            ++depth;
+            break;
+
+        case Command::VAR:
+            if (cmd.type.type == Type::SEQ)
+                return false;
+            ++depth;
+            break;
+
+        case Command::FUN:
+            if (depth == 0) {
+                consumer = j;
+                arg = Functions::WHOLE_ARG;
+                return true;
+            }
+            break;
+
+        case Command::TUP:
+            if (cmd.arg.uint > depth) {
+
+                if (j + 1 >= commands.size() || commands[j + 1].cmd != Command::FUN || !commands[j + 1].closure.empty())
+                    return false;
+
+                consumer = j + 1;
+                arg = cmd.arg.uint - 1 - depth;
+                return true;
+            }
+            depth = depth - cmd.arg.uint + 1;
+            break;
+
+        case Command::EQ:
+            if (depth <= 1) {
+                consumer = j;
+                arg = depth;
+                return true;
+            }
+            --depth;
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// A string that is only looked at by its consumer need not be copied out of the string
+// it was cut from: the call returns an obj::StringView instead, and the consumer is
+// replaced by a variant that accepts one. See Functions::viewers and view_takers.
+void use_views(std::vector<Command>& commands) {
+
+    for (auto& cmd : commands) {
+
+        for (auto& j : cmd.closure) {
+            use_views(j.code);
+        }
+    }
+
+    // Equality is a virtual call on its second operand, so only one operand can be a view
+    // and it must end up second.
+    std::vector<size_t> compared;
+    std::vector<size_t> rotate;
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+
+        auto& cmd = commands[i];
+
+        if (cmd.cmd != Command::FUN || cmd.object != nullptr || !cmd.closure.empty())
+            continue;
+
+        Functions::func_t viewer = functions().viewer((Functions::func_t)cmd.function);
+
+        if (!viewer)
+            continue;
+
+        size_t consumer;
+        size_t arg;
+
+        if (!find_consumer(commands, i, consumer, arg))
+            continue;
+
+        auto& next = commands[consumer];
+
+        if (next.cmd == Command::EQ) {
+
+            if (std::find(compared.begin(), compared.end(), consumer) != compared.end())
+                continue;
+
+            compared.push_back(consumer);
+
+            if (arg == 0)
+                rotate.push_back(consumer);
+
+        } else {
+
+            Functions::func_t taker = functions().view_taker((Functions::func_t)next.function, arg);
+
+            if (!taker)
+                continue;
+
+            next.function = (void*)taker;
+        }
+
+        cmd.function = (void*)viewer;
+        cmd.object = (functions().viewmaker)();
+    }
+
+    if (rotate.empty())
+        return;
+
+    std::vector<Command> ret;
+    ret.reserve(commands.size() + rotate.size());
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+
+        if (std::find(rotate.begin(), rotate.end(), i) != rotate.end())
+            ret.emplace_back(Command::ROT);
+
+        ret.push_back(commands[i]);
+    }
+
+    commands.swap(ret);
+}
+
 }
 
 #include <iostream>
@@ -88,6 +270,10 @@ void optimize(std::vector<Command>& commands, const TypeRuntime& typer) {
             remove_variable(commands, var);
         }
     }
+
+    fuse_functions(commands);
+
+    use_views(commands);
 }
 
 }
@@ -169,10 +169,13 @@ Type parse(I beg, I end, const Type& toplevel_type, TypeRuntime& typer, std::vec
     auto x_ws = *(axe::r_any(" \t\n") | (axe::r_lit('#') & axe::r_many(axe::r_any() - axe::r_lit('\n'), 0)));
 
     auto y_int = axe::e_ref([&](I b, I e) {
-            try {
-                stack.push(Command::VAL, std::stol(std::string(b, e)));
-            } catch (std::exception& ex) {
-                stack.errors.emplace_back("Could not convert '" + std::string(b, e) + "' to an integer.");
+            std::string s(b, e);
+            Int v;
+
+            if (parse_int(s.data(), s.data() + s.size(), v, 10)) {
+                stack.push(Command::VAL, v);
+            } else {
+                stack.errors.emplace_back("Could not convert '" + s + "' to an integer.");
             }
         });
 
@@ -181,10 +184,13 @@ Type parse(I beg, I end, const Type& toplevel_type, TypeRuntime& typer, std::vec
         >> y_int;
 
     auto y_uint = axe::e_ref([&](I b, I e) {
-            try {
-                stack.push(Command::VAL, std::stoul(std::string(b, e), nullptr, 0));
-            } catch (std::exception& ex) {
-                stack.errors.emplace_back("Could not convert '" + std::string(b, e) + "' to an unsigned integer.");
+            std::string s(b, e);
+            UInt v;
+
+            if (parse_uint(s.data(), s.data() + s.size(), v)) {
+                stack.push(Command::VAL, v);
+            } else {
+                stack.errors.emplace_back("Could not convert '" + s + "' to an unsigned integer.");
             }
         });
     
@@ -195,10 +201,13 @@ Type parse(I beg, I end, const Type& toplevel_type, TypeRuntime& typer, std::vec
         >> y_uint;
 
     auto y_float = axe::e_ref([&](I b, I e) {
-            try {
-                stack.push(Command::VAL, std::stod(std::string(b, e)));
-            } catch (std::exception& ex) {
-                stack.errors.emplace_back("Could not convert '" + std::string(b, e) + "' to a floating-point number.");
+            std::string s(b, e);
+            Real v;
+
+            if (parse_real(s.data(), s.data() + s.size(), v)) {
+                stack.push(Command::VAL, v);
+            } else {
+                stack.errors.emplace_back("Could not convert '" + s + "' to a floating-point number.");
             }
         });
 
@@ -0,0 +1,250 @@
+#ifndef __TAB_RECORDS_H
+#define __TAB_RECORDS_H
+
+namespace tab {
+
+// The layout of fixed-width binary input records, declared with the '-B' command-line
+// option as a comma-separated list of fields, e.g. 'u64,i32,f64,s16':
+//
+//   u8, u16, u32, u64  -- unsigned integers, decoded as UInt;
+//   i8, i16, i32, i64  -- signed integers, decoded as Int;
+//   f32, f64           -- floating point numbers, decoded as Real;
+//   sN                 -- a string of N bytes, with trailing NUL bytes removed;
+//   xN                 -- N bytes of padding, skipped.
+//
+// Numbers are in the native byte order of the machine.
+
+struct RecordLayout {
+
+    enum kind_t { UINT, INT, REAL, STRING, PAD };
+
+    struct field_t {
+        kind_t kind;
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<field_t> fields;
+    size_t size;
+
+    RecordLayout() : size(0) {}
+
+    void parse(const std::string& spec) {
+
+        fields.clear();
+        size = 0;
+
+        size_t i = 0;
+
+        while (i <= spec.size()) {
+
+            size_t j = spec.find(',', i);
+
+            if (j == std::string::npos)
+                j = spec.size();
+
+            std::string f = spec.substr(i, j - i);
+            i = j + 1;
+
+            field_t field = { PAD, 0, 0 };
+            size_t n = 0;
+
+            if (f.size() >= 2 && f.find_first_not_of("0123456789", 1) == std::string::npos) {
+                n = std::stoul(f.substr(1));
+            }
+
+            switch (f.empty() ? '\0' : f[0]) {
+            case 'u': field.kind = UINT; break;
+            case 'i': field.kind = INT; break;
+            case 'f': field.kind = REAL; break;
+            case 's': field.kind = STRING; break;
+            case 'x': field.kind = PAD; break;
+            default: n = 0;
+            }
+
+            bool ok = (n > 0);
+
+            if (field.kind == UINT || field.kind == INT) {
+                ok = (n == 8 || n == 16 || n == 32 || n == 64);
+                n = n / 8;
+
+            } else if (field.kind == REAL) {
+                ok = (n == 32 || n == 64);
+                n = n / 8;
+            }
+
+            if (!ok)
+                throw std::runtime_error("Invalid binary record field: '" + f + "'");
+
+            field.offset = size;
+            field.size = n;
+            size += n;
+
+            if (field.kind != PAD) {
+                fields.push_back(field);
+            }
+        }
+
+        if (fields.empty())
+            throw std::runtime_error("A binary record layout needs at least one field.");
+    }
+
+    static Type field_type(const field_t& f) {
+
+        switch (f.kind) {
+        case UINT: return Type(Type::UINT);
+        case INT: return Type(Type::INT);
+        case REAL: return Type(Type::REAL);
+        default: return Type(Type::STRING);
+        }
+    }
+
+    // A single field is decoded into an atom, several fields into a tuple.
+    Type type() const {
+
+        if (fields.size() == 1)
+            return field_type(fields[0]);
+
+        Type ret(Type::TUP);
+        ret.tuple = std::make_shared< std::vector<Type> >();
+
+        for (const field_t& f : fields) {
+            ret.tuple->push_back(field_type(f));
+        }
+
+        return ret;
+    }
+
+    template <typename T, typename U>
+    static T load(const char* p) {
+        U v;
+        ::memcpy(&v, p, sizeof(U));
+        return (T)v;
+    }
+
+    static void decode_field(const field_t& f, const char* p, obj::Object* out) {
+
+        p += f.offset;
+
+        switch (f.kind) {
+        case UINT: {
+            UInt& v = obj::get<obj::UInt>(out).v;
+            switch (f.size) {
+            case 1: v = load<UInt, uint8_t>(p); break;
+            case 2: v = load<UInt, uint16_t>(p); break;
+            case 4: v = load<UInt, uint32_t>(p); break;
+            default: v = load<UInt, uint64_t>(p); break;
+            }
+            break;
+        }
+        case INT: {
+            Int& v = obj::get<obj::Int>(out).v;
+            switch (f.size) {
+            case 1: v = load<Int, int8_t>(p); break;
+            case 2: v = load<Int, int16_t>(p); break;
+            case 4: v = load<Int, int32_t>(p); break;
+            default: v = load<Int, int64_t>(p); break;
+            }
+            break;
+        }
+        case REAL: {
+            Real& v = obj::get<obj::Real>(out).v;
+            v = (f.size == 4 ? load<Real, float>(p) : load<Real, double>(p));
+            break;
+        }
+        default: {
+            const char* e = (const char*)::memchr(p, '\0', f.size);
+            obj::get<obj::String>(out).v.assign(p, e ? e : p + f.size);
+            break;
+        }
+        }
+    }
+
+    obj::Object* make() const {
+
+        if (fields.size() == 1)
+            return obj::make<false>(field_type(fields[0]));
+
+        obj::Tuple* ret = new obj::Tuple;
+
+        for (const field_t& f : fields) {
+            ret->v.push_back(obj::make<false>(field_type(f)));
+        }
+
+        return ret;
+    }
+
+    void decode(const char* p, obj::Object* out) const {
+
+        if (fields.size() == 1) {
+            decode_field(fields[0], p, out);
+            return;
+        }
+
+        obj::Tuple& t = obj::get<obj::Tuple>(out);
+
+        for (size_t i = 0; i < fields.size(); ++i) {
+            decode_field(fields[i], p, t.v[i]);
+        }
+    }
+};
+
+RecordLayout& record_layout() {
+    static RecordLayout ret;
+    return ret;
+}
+
+// Decodes the raw records read from the input into typed values.
+struct SeqRecords : public obj::SeqBase {
+
+    obj::Object* input;
+    obj::Object* holder;
+    const RecordLayout& layout;
+
+    SeqRecords(obj::Object* i, const RecordLayout& l) : input(i), layout(l) {
+        holder = layout.make();
+    }
+
+    ~SeqRecords() {
+        delete holder;
+    }
+
+    obj::Object* next() {
+
+        obj::Object* rec = input->next();
+
+        if (!rec) return nullptr;
+
+        layout.decode(obj::get<obj::String>(rec).v.data(), holder);
+        return holder;
+    }
+
+    UInt skip(UInt n) {
+        return input->skip(n);
+    }
+};
+
+// The type of the top-level '@': lines of text, or typed binary records with '-B'.
+Type input_type() {
+
+    const RecordLayout& layout = record_layout();
+
+    if (layout.fields.empty())
+        return Type(Type::SEQ, { Type(Type::STRING) });
+
+    return Type(Type::SEQ, { layout.type() });
+}
+
+obj::Object* wrap_records(obj::Object* input) {
+
+    const RecordLayout& layout = record_layout();
+
+    if (layout.fields.empty())
+        return input;
+
+    return new SeqRecords(input, layout);
+}
+
+} // namespace tab
+
+#endif
@@ -3,44 +3,102 @@
 
 #include "tab.h"
 
-
-std::istream& file_or_stdin(const std::string& file) {
-
-    if (file.empty())
-        return std::cin;
-
-    static std::ifstream ret;
-
-    ret.open(file);
-
-    if (!ret)
-        throw std::runtime_error("Could not open input file: " + file);
-
-    return ret;
-}
-
 #ifdef _REENTRANT
 #include "threaded.h"
 #endif
 
 
 template <bool SORTED>
-void run(size_t seed, const std::string& program, const std::string& infile, unsigned int debuglevel) {
+void run(size_t seed, const std::string& program, const std::vector<std::string>& infiles, unsigned int debuglevel) {
 
     tab::API<SORTED> api;
 
     api.init(seed);
 
-    static const tab::Type intype(tab::Type::SEQ, { tab::Type(tab::Type::STRING) });
+    tab::Type intype = tab::input_type();
+
+    // The element type of wire format input is only known once its header is read.
+    std::shared_ptr<tab::WireSource> wire;
+
+    if (tab::wire_input()) {
+        wire = tab::open_wire(infiles);
+        intype = tab::Type(tab::Type::SEQ, { wire->type });
+    }
 
     typename tab::API<SORTED>::compiled_t code;
     api.compile(program.begin(), program.end(), intype, code, debuglevel);
 
-    tab::obj::Object* input = new tab::funcs::SeqFile(file_or_stdin(infile));
+    tab::obj::Object* input;
+
+    // A columnar cache of the input file is used if the program allows it.
+    std::vector<tab::obj::Object*> cached = tab::open_cache(infiles, { &code.commands });
+
+    if (wire) {
+        input = new tab::SeqWire<SORTED>(wire);
+
+    } else if (!cached.empty()) {
+        input = cached[0];
+
+    } else if (tab::funcs::sampling().enabled()) {
+        input = tab::funcs::SeqSample::open(infiles[0], 1)[0];
+
+    } else if (infiles.size() > 1) {
+        input = new tab::funcs::SeqFiles(infiles);
+
+    } else {
+        tab::funcs::SeqFile* file;
+
+        if (infiles.empty()) {
+            file = new tab::funcs::SeqFile(std::cin);
+        } else {
+            file = new tab::funcs::SeqFile(infiles[0]);
+        }
+
+        file->reader.start_readahead();
+        input = file;
+    }
+
+    if (!wire) {
+        input = tab::wrap_records(input);
+    }
+
+    tab::funcs::Follow& follow = tab::funcs::follow();
+
+    // Only a map or an array at the top level is built up while reading; anything
+    // else is printed as it is produced, or when the input ends.
+    if (follow.enabled && !code.commands.empty() &&
+        (code.commands.back().cmd == tab::Command::MAP || code.commands.back().cmd == tab::Command::ARR)) {
+
+        tab::obj::Object* result = code.commands.back().object;
+
+        follow.snapshot = [result]() {
+
+            std::unique_ptr<tab::obj::Object> snap(result->clone());
+            snap->merge_end();
+
+            tab::obj::Printer p;
+            snap->print(p);
+
+            // Snapshots are separated by an empty line.
+            p.nl();
+            p.nl();
+            p.flush();
+            ::fflush(stdout);
+        };
+    }
+
     tab::obj::Object* output = api.run(code, input);
 
+    if (tab::wire_output()) {
+        tab::write_wire<SORTED>(code.result, output);
+        return;
+    }
+
     tab::obj::Printer p;
+
+    follow.printer = &p;
     output->print(p);
+    follow.printer = nullptr;
 
     // https://github.com/ivan-tkatchev/tab/issues/4
     if (!p.null) {
@@ -58,11 +116,29 @@ void show_help(const std::string& help_section) {
     }
 
     std::cout <<
-        "Usage: tab [-i inputdata_file] [-f expression_file] [-t N] [-r random seed] [-s] [-v|-vv|-vvv] [-h section] "
+        "Usage: tab [-i inputdata_file...] [-f expression_file] [-R separator] [-B layout] [-F [N|Nl]] [-S N|--sample-bytes F] [-w] [-W] [-t N] [--build-index file] [--cache file] [-r random seed] [-s] [-v|-vv|-vvv] [-h section] "
               << "<expressions...>"
               << std::endl
               << "  -V, --version:   show version." << std::endl
-              << "  -i:   read data from this file instead of stdin." << std::endl
+              << "  -i:   read data from this file instead of stdin. May be repeated, and may be a glob pattern;" << std::endl
+              << "        several files are read one after another. (See the 'filename' function.)" << std::endl
+              << "  -R:   split input records on this separator instead of a newline. May be several bytes long," << std::endl
+              << "        e.g. '\\r\\n' for CRLF line endings; '\\n', '\\r', '\\t', '\\0', '\\xHH' and '\\\\' are recognized." << std::endl
+              << "        '-R csv' reads CSV records, where a newline inside a quoted field does not end the record." << std::endl
+              << "  -B:   read fixed-width binary records with this layout instead of lines, e.g. 'u64,i32,f64,s16'." << std::endl
+              << "        '@' is then a tuple of the decoded fields. Fields are u8..u64, i8..i64, f32, f64," << std::endl
+              << "        sN (an N-byte string) and xN (N bytes of padding); numbers are in native byte order." << std::endl
+              << "  -F:   follow mode: keep reading the input file as it grows, like 'tail -f', and print the result" << std::endl
+              << "        so far every N seconds (default 1) or every N lines with 'Nl'. Needs a single '-i' file." << std::endl
+              << "  -S:   read only N lines, picked at random offsets of the input file, instead of the whole file." << std::endl
+              << "  --sample-bytes: read only this fraction (e.g. 0.01) of the input file, in randomly picked blocks." << std::endl
+              << "        (Sampling needs a single, uncompressed '-i' file; the rest of the file is never read.)" << std::endl
+              << "  --build-index: write a line offset index 'file.tabidx' next to this file and exit. The index is then" << std::endl
+              << "        used to seek in 'skip' and 'stripe', and to give '-t' threads equal numbers of lines." << std::endl
+              << "  -w:   write the result in a typed binary format instead of text, for another 'tab -W' to read." << std::endl
+              << "  -W:   read input written by 'tab -w' instead of text; '@' then has the type of its elements." << std::endl
+              << "  --cache: convert this tab-separated file into a columnar cache 'file.tabcache/' and exit. Programs" << std::endl
+              << "        that only use the input through 'cut(@,\"\\t\",N)' then read just the columns they need." << std::endl
               << "  -f:   prepend code from this file to <expressions...>" << std::endl
               << "  -p:   use this code as the prelude; this code will be prepended to code from file and command line args." << std::endl
               << "  -r:   use a specific random seed." << std::endl
@@ -90,6 +166,73 @@ void show_help(const std::string& help_section) {
               << "  <function name> -- explain the given built-in function." << std::endl;
 }
 
+// Expands a glob pattern; a pattern that matches nothing is kept as a plain file name.
+void add_infiles(const std::string& pattern, std::vector<std::string>& infiles) {
+
+    glob_t g;
+
+    int r = ::glob(pattern.c_str(), GLOB_NOCHECK, nullptr, &g);
+
+    if (r != 0)
+        throw std::runtime_error("Could not expand input file pattern: " + pattern);
+
+    for (size_t i = 0; i < g.gl_pathc; ++i) {
+        infiles.push_back(g.gl_pathv[i]);
+    }
+
+    ::globfree(&g);
+}
+
+// Decodes the backslash escapes accepted by '-R'.
+std::string unescape_separator(const std::string& s) {
+
+    std::string ret;
+
+    for (size_t i = 0; i < s.size(); ++i) {
+
+        if (s[i] != '\\' || i == s.size() - 1) {
+            ret += s[i];
+            continue;
+        }
+
+        ++i;
+
+        switch (s[i]) {
+        case 'n': ret += '\n'; break;
+        case 'r': ret += '\r'; break;
+        case 't': ret += '\t'; break;
+        case '0': ret += '\0'; break;
+        case '\\': ret += '\\'; break;
+        case 'x':
+            if (i + 2 < s.size() && ::isxdigit(s[i+1]) && ::isxdigit(s[i+2])) {
+                ret += (char)std::stoul(s.substr(i + 1, 2), nullptr, 16);
+                i += 2;
+                break;
+            }
+            // Fallthrough.
+        default:
+            throw std::runtime_error("Unknown escape in record separator: \\" + std::string(1, s[i]));
+        }
+    }
+
+    if (ret.empty())
+        throw std::runtime_error("The record separator cannot be empty.");
+
+    return ret;
+}
+
+// A '-F' interval: a number of seconds, or a number of lines suffixed with 'l'.
+bool is_follow_interval(const std::string& s) {
+
+    size_t n = s.size();
+
+    if (n > 0 && s[n - 1] == 'l') {
+        --n;
+    }
+
+    return (n > 0 && s.find_first_not_of("0123456789.") >= n && s[0] != '.');
+}
+
 bool getopt(unsigned char opt, int argc, char** argv, int& i, std::string& out, bool required = true) {
 
     if (argv[i][0] == '-' && argv[i][1] == opt) {
@@ -130,7 +273,9 @@ int main(int argc, char** argv) {
         unsigned int debuglevel = 0;
         bool sorted = false;
         std::string program;
-        std::string infile;
+        std::vector<std::string> infiles;
+        std::vector<std::string> index_files;
+        std::vector<std::string> cache_files;
         std::string programfile;
         size_t seed = ::time(NULL);
         bool help = false;
@@ -165,8 +310,92 @@ int main(int argc, char** argv) {
 
             } else if (getopt('f', argc, argv, i, programfile)) {
 
-            } else if (getopt('i', argc, argv, i, infile)) {
-                //
+            } else if (arg.substr(0, 2) == "-F") {
+
+                tab::funcs::Follow& follow = tab::funcs::follow();
+                follow.enabled = true;
+                tab::obj::Printer::line_buffered() = true;
+
+                // The interval is optional, so only take the next argument if it looks like one.
+                out = arg.substr(2);
+
+                if (out.empty() && i < argc - 1 && is_follow_interval(argv[i + 1])) {
+                    ++i;
+                    out = argv[i];
+                }
+
+                if (!out.empty()) {
+
+                    if (!is_follow_interval(out))
+                        throw std::runtime_error("Invalid '-F' interval: " + out);
+
+                    if (out.back() == 'l') {
+                        follow.lines = std::stoul(out);
+                    } else {
+                        follow.seconds = std::stod(out);
+                    }
+                }
+
+            } else if (getopt('S', argc, argv, i, out)) {
+
+                tab::funcs::sampling().lines = std::stoul(out);
+
+            } else if (arg == "--build-index") {
+
+                if (i == argc - 1)
+                    throw std::runtime_error("The '--build-index' command line argument expects an argument.");
+
+                ++i;
+                add_infiles(argv[i], index_files);
+
+            } else if (arg == "--cache") {
+
+                if (i == argc - 1)
+                    throw std::runtime_error("The '--cache' command line argument expects an argument.");
+
+                ++i;
+                add_infiles(argv[i], cache_files);
+
+            } else if (arg == "--sample-bytes") {
+
+                if (i == argc - 1)
+                    throw std::runtime_error("The '--sample-bytes' command line argument expects an argument.");
+
+                ++i;
+                double f = std::stod(argv[i]);
+
+                if (!(f > 0 && f <= 1))
+                    throw std::runtime_error("The '--sample-bytes' fraction must be in (0, 1].");
+
+                tab::funcs::sampling().fraction = f;
+
+            } else if (getopt('B', argc, argv, i, out)) {
+
+                tab::record_layout().parse(out);
+                tab::funcs::record_size() = tab::record_layout().size;
+
+            } else if (arg == "-w") {
+
+                tab::wire_output() = true;
+
+            } else if (arg == "-W") {
+
+                tab::wire_input() = true;
+
+            } else if (getopt('R', argc, argv, i, out)) {
+
+                if (out == "csv") {
+                    tab::funcs::csv_records() = true;
+                    tab::funcs::record_separator() = "\n";
+
+                } else {
+                    tab::funcs::csv_records() = false;
+                    tab::funcs::record_separator() = unescape_separator(out);
+                }
+
+            } else if (getopt('i', argc, argv, i, out)) {
+
+                add_infiles(out, infiles);
 
             } else if (getopt('h', argc, argv, i, help_section, false)) {
                 help = true;
@@ -212,6 +441,19 @@ int main(int argc, char** argv) {
 
         // //
 
+        if (!index_files.empty() || !cache_files.empty()) {
+
+            for (const std::string& f : index_files) {
+                tab::funcs::build_index(f);
+            }
+
+            for (const std::string& f : cache_files) {
+                tab::build_cache(f);
+            }
+
+            return 0;
+        }
+
         if (help || !has_program) {
             show_help(help_section);
             return 1;
@@ -223,12 +465,36 @@ int main(int argc, char** argv) {
 
         // //
 
+        if (tab::funcs::follow().enabled && infiles.size() != 1)
+            throw std::runtime_error("Follow mode ('-F') needs exactly one input file given with '-i'.");
+
+        if (tab::funcs::sampling().enabled()) {
+
+            if (infiles.size() != 1 || tab::funcs::follow().enabled || tab::funcs::csv_records())
+                throw std::runtime_error("Sampling needs exactly one input file given with '-i', and cannot be used with '-F' or '-R csv'.");
+
+            tab::funcs::sampling().seed = seed;
+        }
+
+        if (tab::wire_input()) {
+
+            if (tab::funcs::follow().enabled || tab::funcs::sampling().enabled() || tab::funcs::record_size())
+                throw std::runtime_error("Wire format input ('-W') cannot be used with '-F', '-S', '--sample-bytes' or '-B'.");
+        }
+
+        if (tab::wire_output() && tab::funcs::follow().enabled)
+            throw std::runtime_error("Wire format output ('-w') cannot be used with '-F'.");
+
 #ifdef _REENTRANT
         if (nthreads > 0) {
+
+            if (tab::funcs::follow().enabled)
+                throw std::runtime_error("Follow mode ('-F') cannot be used with '-t'.");
+
             if (sorted) {
-                run_threaded<true>(seed, program, nthreads, infile, debuglevel);
+                run_threaded<true>(seed, program, nthreads, infiles, debuglevel);
             } else {
-                run_threaded<false>(seed, program, nthreads, infile, debuglevel);
+                run_threaded<false>(seed, program, nthreads, infiles, debuglevel);
             }
 
             return 0;
@@ -236,9 +502,9 @@ int main(int argc, char** argv) {
 #endif
             
         if (sorted) {
-            run<true>(seed, program, infile, debuglevel);
+            run<true>(seed, program, infiles, debuglevel);
         } else {
-            run<false>(seed, program, infile, debuglevel);
+            run<false>(seed, program, infiles, debuglevel);
         }
         
     } catch (std::exception& e) {
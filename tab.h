@@ -4,14 +4,20 @@
 #include "deps.h"
 #include "help.h"
 #include "atom.h"
+#include "number.h"
 #include "type.h"
 #include "command.h"
 #include "infer.h"
 #include "optimize.h"
 #include "parse.h"
 #include "hash.h"
+#include "inflate.h"
+#include "nfa.h"
 #include "object.h"
 #include "funcs.h"
+#include "records.h"
+#include "wire.h"
+#include "cache.h"
 #include "exec.h"
 #include "api.h"
 
@@ -0,0 +1,144 @@
+import sys
+import os
+import subprocess
+import time
+import random
+
+# Throughput benchmarks for the hot paths of 'tab'.
+#
+# Usage: [TAB=path/to/tab] python3 bench.py [name...]
+#
+# Input files are generated once into /tmp and reused between runs.
+
+TMPDIR = os.environ.get("TAB_BENCH_DIR", "/tmp")
+
+# The binary to benchmark; set TAB to compare against another build.
+TAB = os.environ.get("TAB", "../tab")
+
+def make_wide_tsv(path, nlines=200000, ncols=40):
+    if os.path.exists(path):
+        return path
+    rnd = random.Random(1234)
+    with open(path, "w") as f:
+        for i in range(nlines):
+            f.write("\t".join(str(rnd.randint(0, 1 << 40)) for _ in range(ncols)))
+            f.write("\n")
+    return path
+
+def wide_tsv():
+    return make_wide_tsv(os.path.join(TMPDIR, "tab_bench_wide.tsv"))
+
+# A copy of the same file, with a columnar cache built by 'tab --cache'.
+def wide_tsv_cached():
+    path = make_wide_tsv(os.path.join(TMPDIR, "tab_bench_wide_cached.tsv"))
+    if not os.path.exists(path + ".tabcache/meta"):
+        subprocess.check_call([TAB, "--cache", path])
+    return path
+
+def make_numbers(path, nlines=2000000):
+    if os.path.exists(path):
+        return path
+    rnd = random.Random(1234)
+    with open(path, "w") as f:
+        for i in range(nlines):
+            f.write("%d\t%d\n" % (rnd.randint(-1 << 40, 1 << 40), rnd.randint(0, 1 << 20)))
+    return path
+
+def numbers():
+    return make_numbers(os.path.join(TMPDIR, "tab_bench_numbers.tsv"))
+
+# One number per line, for the string to number conversions.
+def make_column(path, fmt, gen, nlines=4000000):
+    if os.path.exists(path):
+        return path
+    rnd = random.Random(1234)
+    with open(path, "w") as f:
+        for i in range(nlines):
+            f.write(fmt % gen(rnd))
+    return path
+
+def ints():
+    return make_column(os.path.join(TMPDIR, "tab_bench_ints.txt"), "%d\n",
+                       lambda rnd: rnd.randint(-1 << 40, 1 << 40))
+
+def reals():
+    return make_column(os.path.join(TMPDIR, "tab_bench_reals.txt"), "%.*f\n",
+                       lambda rnd: (rnd.randint(0, 6), rnd.uniform(-1e6, 1e6)))
+
+def make_access_log(path, nlines=1000000):
+    if os.path.exists(path):
+        return path
+    rnd = random.Random(1234)
+    methods = ["GET", "GET", "GET", "POST", "HEAD"]
+    with open(path, "w") as f:
+        for i in range(nlines):
+            f.write('10.%d.%d.%d - - [%02d/Oct/2023:%02d:%02d:%02d +0200] "%s /p/%d?id=%d&s=x HTTP/1.1" %d %d "https://example.com/%d" "Mozilla/5.0 (X11; Linux x86_64) Test/%d"\n' %
+                    (rnd.randint(0, 255), rnd.randint(0, 255), rnd.randint(0, 255),
+                     rnd.randint(1, 28), rnd.randint(0, 23), rnd.randint(0, 59), rnd.randint(0, 59),
+                     rnd.choice(methods), rnd.randint(0, 1000), rnd.randint(0, 1 << 20),
+                     rnd.choice([200, 200, 200, 304, 404]), rnd.randint(0, 100000),
+                     rnd.randint(0, 100), rnd.randint(1, 9)))
+    return path
+
+def access_log():
+    return make_access_log(os.path.join(TMPDIR, "tab_bench_access.log"))
+
+def make_urls(path, nlines=1000000):
+    if os.path.exists(path):
+        return path
+    rnd = random.Random(1234)
+    with open(path, "w") as f:
+        for i in range(nlines):
+            f.write("https://example.com/p/%d?utm_source=s%d&utm_medium=m%d&q=a%%20b+%d&page=%d&id=%d\n" %
+                    (rnd.randint(0, 1000), rnd.randint(0, 9), rnd.randint(0, 9),
+                     rnd.randint(0, 1 << 20), rnd.randint(1, 50), rnd.randint(0, 1 << 30)))
+    return path
+
+def urls():
+    return make_urls(os.path.join(TMPDIR, "tab_bench_urls.txt"))
+
+# name -> (input file generator, tab expression, read input from stdin?)
+BENCHES = [
+    ("getline-mmap",  wide_tsv, "count.@", False),
+    ("getline-stdin", wide_tsv, "count.@", True),
+    ("cut-wide",      wide_tsv, "sum.[. count.cut(@,\"\\t\") .]", False),
+    ("cutn-wide",     wide_tsv, "sum.[. uint.cut(@,\"\\t\",39) .]", False),
+    ("cutn-last",     wide_tsv, "sum.[. uint.cut(@,\"\\t\",-1) .]", False),
+    ("cutn-multibyte", wide_tsv, "count.[. cut(@,\"\\t9\",-1) .]", False),
+    ("cut-cached",    wide_tsv_cached, "sum.[. uint.cut(@,\"\\t\",39) .]", False),
+    ("print-int",     numbers,  "[. int.cut(@,\"\\t\",0), uint.cut(@,\"\\t\",1) .]", False),
+    ("parse-int",     ints,     "sum.[. int.@ .]", False),
+    ("parse-real",    reals,    "sum.[. real.@ .]", False),
+    ("weblog",        access_log, "sum.[. weblog(@)~6 .]", False),
+    ("weblog-recut",  access_log, "sum.[. uint.recut(@, \"\\\" | \\\"\", 2u) .]", False),
+    ("regex-grepif",  access_log, "count.[. grepif(@, \"\\\" 40[34] [0-9]+ \\\"\") .]", False),
+    ("regex-grep",    access_log, "sum.[. count(grep(@, \"(GET|POST) ([^ ?]+)\")) .]", False),
+    ("regex-replace", access_log, "count.[. replace(@, \"[0-9]+\", \"N\") .]", False),
+    ("regex-recut",   access_log, "sum.[. uint.recut(@, \"\\\" +\\\"?\", 1u) .]", False),
+    ("url-params",    urls,     "count.[. url_getparam(@,\"utm_source\"), url_getparam(@,\"utm_medium\"), url_getparam(@,\"q\"), url_getparam(@,\"page\"), url_getparam(@,\"id\") .]", False),
+    ("print-real",    numbers,  "[. real(cut(@,\"\\t\",1)) / 7.0 .]", False),
+]
+
+def run_one(infile, expr, stdin, repeat=3):
+    best = None
+    for _ in range(repeat):
+        t = time.time()
+        if stdin:
+            with open(infile, "rb") as f:
+                subprocess.check_output([TAB, expr], stdin=f)
+        else:
+            subprocess.check_output([TAB, "-i", infile, expr])
+        t = time.time() - t
+        best = t if best is None else min(best, t)
+    return best
+
+def go(names):
+    for name, gen, expr, stdin in BENCHES:
+        if names and name not in names:
+            continue
+        infile = gen()
+        size = os.path.getsize(infile)
+        t = run_one(infile, expr, stdin)
+        print("%-20s %8.3f s %10.1f MB/s" % (name, t, size / t / 1e6))
+
+go(sys.argv[1:])
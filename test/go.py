@@ -4,12 +4,23 @@ import subprocess
 import glob
 import struct
 import time
+import os
+import shutil
+import tempfile
 
-def exec(*popenargs, **kwargs):
+def exec(*popenargs, follow=0, **kwargs):
     proctime = time.time()
     with subprocess.Popen(*popenargs, stdout=subprocess.PIPE, stderr=subprocess.PIPE, **kwargs) as process:
         try:
-            output, err = process.communicate()
+            if follow:
+                # Follow mode never exits on its own, so it is stopped after a while.
+                try:
+                    output, err = process.communicate(timeout=follow)
+                except subprocess.TimeoutExpired:
+                    process.kill()
+                    output, err = process.communicate()
+            else:
+                output, err = process.communicate()
         except:
             process.kill()
             process.wait()
@@ -17,22 +28,79 @@ def exec(*popenargs, **kwargs):
         retcode = process.poll()
     return retcode, output, err, time.time() - proctime
 
-def run(filename, arg, expected, log, infile = "../LICENSE.txt", errcode = 0, sort=False):
+def make_sidecar(filename, infile, how):
+    # The cache or line index is built for a copy of the input file, which may then be changed.
+    tmpdir = tempfile.mkdtemp()
+    copy = os.path.join(tmpdir, os.path.basename(infile))
+    shutil.copy(infile, copy)
+
+    cache = how.startswith("--cache")
+    retcode, out, err, proctime = exec(["../tab", "--cache" if cache else "--build-index", copy])
+
+    if retcode != 0 or not os.path.exists(copy + (".tabcache/meta" if cache else ".tabidx")):
+        raise Exception("Test failed for: %s -- could not build '%s': '%s'" % (filename, how, err))
+
+    with open(copy, 'rb') as f:
+        lines = f.readlines()
+
+    if how.endswith("-then-append"):
+        with open(copy, 'ab') as f:
+            f.write(lines[0])
+
+    elif how.endswith("-then-rewrite"):
+        # The same size but different contents, with the old timestamps put back.
+        st = os.stat(copy)
+        with open(copy, 'wb') as f:
+            f.write(b''.join(reversed(lines)))
+        os.utime(copy, ns=(st.st_atime_ns, st.st_mtime_ns))
+
+    return tmpdir, copy
+
+def run(filename, arg, expected, log, infile = "../LICENSE.txt", errcode = 0, sort=False, opts=[], exact=False):
     print(">>>", arg.replace('\n',' '))
 
-    threads = (arg.find("-->") >= 0)
+    sidecar = [ o for o in opts if o.startswith("--cache") or o.startswith("--build-index") ]
 
-    retcode, out, err, proctime = exec(["../tab", "-r", "1234", "-i", infile, arg] +
+    if sidecar:
+        opts = [ o for o in opts if o not in sidecar ]
+
+        # The results from the cache or index must be exactly those from the file itself.
+        if sidecar[0] in ("--cache", "--build-index"):
+            run(filename, arg, expected, log, infile, errcode, sort, opts, exact=True)
+
+        tmpdir, infile = make_sidecar(filename, infile, sidecar[0])
+
+        try:
+            run(filename, arg, expected, log, infile, errcode, sort, opts, exact=True)
+        finally:
+            shutil.rmtree(tmpdir)
+        return
+
+    threads = (arg.find("-->") >= 0) and not any(o.startswith("-t") for o in opts)
+    follow = any(o.startswith("-F") for o in opts)
+
+    retcode, out, err, proctime = exec(["../tab", "-r", "1234", "-i", infile] + opts + [arg] +
                                        (["-s"] if sort else []) +
-                                       (["-t99"] if threads else []))
+                                       (["-t99"] if threads else []),
+                                       follow=(1 if follow else 0))
     log[filename] = proctime
 
-    if errcode != retcode:
+    if errcode != retcode and not follow:
         raise Exception("Test failed for: %s, '%s' -- return code %d" % (filename, arg, retcode))
     out = out.decode('ascii')
     err = err.decode('ascii')
+    if errcode != 0 and '!!!\n' in expected:
+        # The output printed before the error must come out in full.
+        expected, experr = expected.split('!!!\n')
+        if out.rstrip('\n') != expected.rstrip('\n'):
+            raise Exception("Test failed for: %s, '%s' -- output is '%s'" % (filename, arg, out))
+        if not experr.startswith(err):
+            raise Exception("Test failed for: %s, '%s' -- stderr is '%s'" % (filename, arg, err))
+        return
     if errcode != 0:
         out, err = err, out
+    if (follow or exact) and out.rstrip('\n') != expected.rstrip('\n'):
+        raise Exception("Test failed for: %s, '%s' -- output is '%s'" % (filename, arg, out))
     if not expected.startswith(out):
         raise Exception("Test failed for: %s, '%s' -- output is '%s'" % (filename, arg, out))
     if not len(err) == 0:
@@ -50,7 +118,10 @@ def go(sort=False, tests=False):
         txt = txt.split('===>\n')
 
         if len(txt) == 3:
-            run(i, txt[1], txt[2], log, infile=txt[0].replace('\n',''), sort=sort)
+            # The input file may be followed by extra command-line options, one per line.
+            opts = [ x for x in txt[0].split('\n') if x ]
+            run(i, txt[1], txt[2], log, infile=opts[0], sort=sort, opts=opts[1:],
+                errcode=(1 if '!!!\n' in txt[2] else 0))
         elif len(txt) == 2:
             run(i, txt[0], txt[1], log, sort=sort)
         elif len(txt) == 1:
@@ -4,29 +4,84 @@
 #include <mutex>
 #include <condition_variable>
 #include <memory>
+#include <atomic>
+#include <exception>
 
 namespace tab {
 
 struct ThreadedSeqFile : public obj::SeqBase {
 
-    obj::String* holder() {
-        static thread_local obj::String ret;
-        return &ret;
+    // Scatter threads claim a whole block of lines under the lock and then
+    // split it into lines privately, so there is one lock per block instead of per line.
+    static const size_t BLOCKSIZE = 256*1024;
+
+    struct block_t {
+        std::string data;
+        funcs::Linereader reader;
+        obj::String holder;
+
+        block_t() : reader(nullptr, nullptr) {}
+    };
+
+    block_t& block() {
+        static thread_local block_t ret;
+        return ret;
     }
 
     std::mutex mutex;
     funcs::Linereader reader;
+    std::string name;
     
     ThreadedSeqFile(std::istream& infile) : reader(infile) {}
 
+    ThreadedSeqFile(const std::string& fname) : reader(fname), name(fname) {}
+
     obj::Object* next() {
-        std::lock_guard<std::mutex> l(mutex);
 
-        bool ok = reader.getline(holder()->v);
+        block_t& blk = block();
+
+        while (!blk.reader.getline(blk.holder.v)) {
+
+            std::lock_guard<std::mutex> l(mutex);
+
+            if (!reader.getblock(blk.data, BLOCKSIZE))
+                return nullptr;
 
-        if (!ok) return nullptr;
+            blk.reader.bufi = blk.data.data();
+            blk.reader.bufe = blk.data.data() + blk.data.size();
 
-        return holder();
+            funcs::current_filename() = name;
+        }
+
+        return &blk.holder;
+    }
+};
+
+struct FileQueue {
+
+    std::mutex mutex;
+    std::vector<std::string> files;
+    size_t filei;
+
+    FileQueue(const std::vector<std::string>& f) : files(f), filei(0) {}
+};
+
+struct ThreadedSeqFiles : public funcs::SeqFiles {
+
+    std::shared_ptr<FileQueue> queue;
+
+    ThreadedSeqFiles(std::shared_ptr<FileQueue> q) : queue(q) {}
+
+    bool next_file(std::string& fname) {
+
+        std::lock_guard<std::mutex> l(queue->mutex);
+
+        if (queue->filei >= queue->files.size())
+            return false;
+
+        fname = queue->files[queue->filei];
+        ++(queue->filei);
+        return true;
     }
 };
 
@@ -37,6 +92,7 @@ struct ThreadGroupSeq : public obj::SeqBase {
         std::condition_variable can_produce;
         std::mutex mutex;
         bool finished;
+        std::exception_ptr error;
 
         syncvar_t() : result(nullptr), finished(false) {}
     };
@@ -79,17 +135,17 @@ struct ThreadGroupSeq : public obj::SeqBase {
             }
         }
 
-    } catch (std::exception& e) {
-        std::cerr << "ERROR: " << e.what() << std::endl;
-        std::exit(1);
-
     } catch (...) {
-        std::cerr << "UNKNOWN ERROR." << std::endl;
-        std::exit(1);
+
+        // The error is raised again in the main thread, so that the output printed so
+        // far is flushed before the program exits.
+        std::unique_lock<std::mutex> l(sync->mutex);
+        sync->error = std::current_exception();
+        sync->finished = true;
     }
 
     template <typename API, typename T>
-    ThreadGroupSeq(API& api, std::vector<T>& codes, std::vector<obj::Object*>& seqs, obj::Object* input) :
+    ThreadGroupSeq(API& api, std::vector<T>& codes, std::vector<obj::Object*>& seqs, std::vector<obj::Object*>& inputs) :
         nthreads(codes.size()), last_used_thread(-1) {
 
         syncs.resize(nthreads);
@@ -102,7 +158,7 @@ struct ThreadGroupSeq : public obj::SeqBase {
 
         for (size_t i = 0; i < nthreads; ++i) {
             threads.emplace_back(&ThreadGroupSeq::threadfun<API, T>, this,
-                                 std::ref(api), std::ref(codes[i]), std::ref(seqs[i]), input, queued[i]);
+                                 std::ref(api), std::ref(codes[i]), std::ref(seqs[i]), inputs[i], queued[i]);
         }
     }
 
@@ -140,6 +196,10 @@ struct ThreadGroupSeq : public obj::SeqBase {
 
             if (sync->finished) {
                 sync->mutex.unlock();
+
+                if (sync->error)
+                    std::rethrow_exception(sync->error);
+
                 last_used_thread = -1;
                 --nthreads;
 
@@ -159,22 +219,175 @@ struct ThreadGroupSeq : public obj::SeqBase {
 
 };
 
+// Output of a scatter thread that prints its own results: lines are formatted into
+// a private buffer, and only whole buffers of complete lines are written to stdout.
+struct LockedPrinter : public obj::Printer {
+
+    // Thrown to stop printing once another thread has failed.
+    struct Stopped {};
+
+    std::mutex& mutex;
+    const std::atomic<bool>& failed;
+
+    LockedPrinter(std::mutex& m, const std::atomic<bool>& f) : mutex(m), failed(f) {}
+
+    ~LockedPrinter() {
+        flush();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> l(mutex);
+        obj::Printer::flush();
+    }
+
+    void val(const std::string& v) {
+        bump();
+        buf += v;
+    }
+
+    void nl() {
+        bump();
+        buf += '\n';
+
+        if (buf.size() >= BUFSIZE) {
+            flush();
+        }
+
+        if (failed.load(std::memory_order_relaxed)) {
+            throw Stopped();
+        }
+    }
+};
+
+// Without a gather expression there is nothing to merge, so every scatter thread
+// prints its results directly instead of handing them one by one to the main thread.
+template <typename API, typename T>
+void run_direct(API& api, std::vector<T>& codes, std::vector<obj::Object*>& inputs) {
+
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+
+    for (size_t n = 0; n < codes.size(); ++n) {
+
+        threads.emplace_back([&api, &codes, &inputs, &mutex, &failed, &error, n]() {
+
+            try {
+                obj::Object* r = api.run(codes[n], inputs[n]);
+
+                LockedPrinter p(mutex, failed);
+                r->print(p);
+
+                if (!p.null) {
+                    p.nl();
+                }
+
+            } catch (LockedPrinter::Stopped&) {
+
+            } catch (...) {
+
+                // The other threads stop at their next line and flush what they have
+                // printed; the first error is raised again once they are done.
+                std::lock_guard<std::mutex> l(mutex);
+
+                if (!error) {
+                    error = std::current_exception();
+                }
+
+                failed = true;
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Splits [b, e) into n ranges of roughly equal size, each ending on a line boundary.
+std::vector< std::pair<const char*, const char*> > split_lines(const char* b, const char* e, size_t n) {
+
+    std::vector< std::pair<const char*, const char*> > ret;
+    size_t size = e - b;
+    const char* prev = b;
+    const std::string& sep = funcs::record_separator();
+
+    for (size_t i = 1; i <= n; ++i) {
+
+        const char* x = b + (size * i) / n;
+
+        if (x < prev) {
+            x = prev;
+        }
+
+        if (i == n) {
+            x = e;
+
+        } else if (funcs::record_size()) {
+
+            size_t recsize = funcs::record_size();
+            x = b + (x - b) / recsize * recsize;
+
+            if (x < prev) {
+                x = prev;
+            }
+
+        } else if (x > b && x < e) {
+
+            // Back up so that a separator straddling 'x' is not cut in half.
+            const char* from = ((size_t)(x - prev) > sep.size() ? x - sep.size() : prev);
+            const char* nl = funcs::find_separator(from, e, sep);
+            x = (nl ? nl + sep.size() : e);
+        }
+
+        ret.emplace_back(prev, x);
+        prev = x;
+    }
+
+    return ret;
+}
+
+// Splits [b, e) into n ranges with roughly equal numbers of lines, using the line offset index.
+std::vector< std::pair<const char*, const char*> > split_indexed(const char* b, const char* e, const std::vector<UInt>& offsets, size_t n) {
+
+    std::vector< std::pair<const char*, const char*> > ret;
+    const char* prev = b;
+
+    for (size_t i = 1; i <= n; ++i) {
+
+        const char* x = (i == n ? e : b + offsets[(offsets.size() * i) / n]);
+
+        ret.emplace_back(prev, x);
+        prev = x;
+    }
+
+    return ret;
+}
+
 }
 
 template <bool SORTED>
 void run_threaded(size_t seed, const std::string& program, size_t nthreads, 
-                  const std::string& infile, unsigned int debuglevel) {
+                  const std::vector<std::string>& infiles, unsigned int debuglevel) {
 
     if (nthreads == 0)
         nthreads = 1;
 
     std::string scatter;
     std::string gather;
+    bool direct = false;
 
     {
         size_t i = program.find("-->");
 
         if (i == std::string::npos) {
+            // Wire format output is a single stream, so it always goes through a gather step.
+            direct = !tab::wire_output();
             scatter = program;
             gather = "@";
 
@@ -188,11 +401,17 @@ void run_threaded(size_t seed, const std::string& program, size_t nthreads,
 
     api.init(seed);
 
-    static const tab::Type intype(tab::Type::SEQ, { tab::Type(tab::Type::STRING) });
+    tab::Type intype = tab::input_type();
 
     typedef typename tab::API<SORTED>::compiled_t compiled_t;
 
-    tab::obj::Object* input = new tab::ThreadedSeqFile(file_or_stdin(infile));
+    // The element type of wire format input is only known once its header is read.
+    std::shared_ptr<tab::WireSource> wire;
+
+    if (tab::wire_input()) {
+        wire = tab::open_wire(infiles);
+        intype = tab::Type(tab::Type::SEQ, { wire->type });
+    }
 
     std::vector<compiled_t> codes;
     std::vector<tab::obj::Object*> seqs;
@@ -206,6 +425,9 @@ void run_threaded(size_t seed, const std::string& program, size_t nthreads,
 
         api.compile(scatter.begin(), scatter.end(), intype, code, (n == 0 ? debuglevel : 0));
 
+        if (direct)
+            continue;
+
         seqs[n] = (tab::functions().seqmaker)(code.result);
 
         if (seqs[n]) {
@@ -213,16 +435,105 @@ void run_threaded(size_t seed, const std::string& program, size_t nthreads,
         }
     }
 
+    std::vector<tab::obj::Object*> inputs;
+    tab::funcs::MappedFile mapped;
+
+    // A columnar cache of the input file is used if the scatter program allows it.
+    std::vector< std::vector<tab::Command>* > programs;
+
+    for (auto& code : codes) {
+        programs.push_back(&code.commands);
+    }
+
+    std::vector<tab::obj::Object*> cached = tab::open_cache(infiles, programs);
+
+    if (wire) {
+
+        // Scatter threads take turns reading whole elements from the one stream.
+        for (size_t n = 0; n < nthreads; ++n) {
+            inputs.push_back(new tab::SeqWire<SORTED>(wire));
+        }
+
+    } else if (!cached.empty()) {
+
+        // Each scatter thread reads its own range of rows.
+        inputs = cached;
+
+    } else if (tab::funcs::sampling().enabled()) {
+
+        // Each scatter thread reads its own share of the sampled offsets.
+        inputs = tab::funcs::SeqSample::open(infiles[0], nthreads);
+
+    } else if (infiles.size() > 1) {
+
+        // Scatter threads claim whole files from a shared list.
+        auto queue = std::make_shared<tab::FileQueue>(infiles);
+
+        for (size_t n = 0; n < nthreads; ++n) {
+            inputs.push_back(new tab::ThreadedSeqFiles(queue));
+        }
+
+    } else if (infiles.size() == 1 && !tab::funcs::csv_records() && mapped.open(infiles[0]) && !tab::is_gzip(mapped.data, mapped.data + mapped.size)) {
+
+        // Each scatter thread reads its own slice of a regular file, no locking needed.
+        // With a line offset index the slices have equal numbers of lines, otherwise equal sizes.
+        tab::funcs::LineIndex index;
+        std::vector< std::pair<const char*, const char*> > slices;
+
+        if (!tab::funcs::record_size() &&
+            index.load(mapped, tab::funcs::record_separator(), tab::funcs::LineIndex::path(infiles[0])) &&
+            index.offsets.size() >= nthreads) {
+
+            slices = tab::split_indexed(mapped.data, mapped.data + mapped.size, index.offsets, nthreads);
+
+        } else {
+            slices = tab::split_lines(mapped.data, mapped.data + mapped.size, nthreads);
+        }
+
+        for (const auto& r : slices) {
+            inputs.push_back(new tab::funcs::SeqFile(r.first, r.second, infiles[0]));
+        }
+
+    } else {
+
+        tab::obj::Object* input;
+
+        if (infiles.empty()) {
+            input = new tab::ThreadedSeqFile(std::cin);
+        } else {
+            input = new tab::ThreadedSeqFile(infiles[0]);
+        }
+
+        inputs.assign(nthreads, input);
+    }
+
+    if (!wire && cached.empty()) {
+
+        for (auto& i : inputs) {
+            i = tab::wrap_records(i);
+        }
+    }
+
+    if (direct) {
+        tab::run_direct(api, codes, inputs);
+        return;
+    }
+
     compiled_t gathered;
     api.compile(gather.begin(), gather.end(), codes[0].result, gathered, debuglevel);
 
-    tab::ThreadGroupSeq* tgs = new tab::ThreadGroupSeq(api, codes, seqs, input);
+    tab::ThreadGroupSeq* tgs = new tab::ThreadGroupSeq(api, codes, seqs, inputs);
 
     tab::obj::Object* output = api.run(gathered, tgs);
 
-    tab::obj::Printer p;
-    output->print(p);
-    p.nl();
+    if (tab::wire_output()) {
+        tab::write_wire<SORTED>(gathered.result, output);
+
+    } else {
+        tab::obj::Printer p;
+        output->print(p);
+        p.nl();
+    }
 
     delete tgs;
 }
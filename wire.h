@@ -0,0 +1,530 @@
+#ifndef __TAB_WIRE_H
+#define __TAB_WIRE_H
+
+namespace tab {
+
+// A compact typed binary format for passing results from one 'tab' to another
+// ('tab -w ... | tab -W ...') without printing and re-parsing text.
+//
+// The stream starts with a magic string and the element type, followed by the
+// elements of the result, each one prefixed with its length in bytes. A result that
+// is not a sequence is sent as the sequence it would be turned into by the '-->'
+// gather step: the elements of an array, the key-value pairs of a map, or a single
+// element otherwise.
+//
+// Integers are varints (zigzag-encoded if signed), reals are 8 raw bytes, strings
+// and arrays are prefixed by their length, maps by their number of entries.
+
+namespace wire {
+
+static const char MAGIC[] = "TABWIRE1";
+static const size_t MAGIC_SIZE = 8;
+
+inline void put_varint(UInt v, std::string& out) {
+
+    while (v >= 0x80) {
+        out += (char)(v | 0x80);
+        v >>= 7;
+    }
+
+    out += (char)v;
+}
+
+inline UInt get_varint(const char*& p, const char* e) {
+
+    UInt ret = 0;
+    unsigned int shift = 0;
+
+    while (1) {
+
+        if (p == e || shift > 63)
+            throw std::runtime_error("Malformed wire format input.");
+
+        unsigned char c = *p++;
+        ret |= (UInt)(c & 0x7F) << shift;
+
+        if (!(c & 0x80))
+            return ret;
+
+        shift += 7;
+    }
+}
+
+inline UInt zigzag(Int v) {
+    return ((UInt)v << 1) ^ (UInt)(v >> 63);
+}
+
+inline Int unzigzag(UInt v) {
+    return (Int)(v >> 1) ^ -(Int)(v & 1);
+}
+
+void put_type(const Type& t, std::string& out) {
+
+    switch (t.type) {
+    case Type::ATOM:
+        switch (t.atom) {
+        case Type::INT: out += 'i'; break;
+        case Type::UINT: out += 'u'; break;
+        case Type::REAL: out += 'r'; break;
+        case Type::STRING: out += 's'; break;
+        }
+        return;
+
+    case Type::TUP:
+        out += 't';
+        put_varint(t.tuple->size(), out);
+        break;
+
+    case Type::ARR:
+        out += 'a';
+        break;
+
+    case Type::MAP:
+        out += 'm';
+        break;
+
+    default:
+        throw std::runtime_error("Cannot write a " + Type::print(t) + " in wire format.");
+    }
+
+    for (const Type& x : *(t.tuple)) {
+        put_type(x, out);
+    }
+}
+
+Type get_type(const char*& p, const char* e) {
+
+    if (p == e)
+        throw std::runtime_error("Malformed wire format input.");
+
+    char c = *p++;
+    Type ret;
+    size_t n = 0;
+
+    switch (c) {
+    case 'i': return Type(Type::INT);
+    case 'u': return Type(Type::UINT);
+    case 'r': return Type(Type::REAL);
+    case 's': return Type(Type::STRING);
+    case 't': ret = Type(Type::TUP); n = get_varint(p, e); break;
+    case 'a': ret = Type(Type::ARR); n = 1; break;
+    case 'm': ret = Type(Type::MAP); n = 2; break;
+    default:
+        throw std::runtime_error("Malformed wire format input.");
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        ret.push(get_type(p, e));
+    }
+
+    return ret;
+}
+
+template <typename T>
+void put_atom(const T& v, std::string& out);
+
+template <>
+void put_atom(const Int& v, std::string& out) {
+    put_varint(zigzag(v), out);
+}
+
+template <>
+void put_atom(const UInt& v, std::string& out) {
+    put_varint(v, out);
+}
+
+template <>
+void put_atom(const Real& v, std::string& out) {
+    out.append((const char*)&v, sizeof(Real));
+}
+
+template <>
+void put_atom(const std::string& v, std::string& out) {
+    put_varint(v.size(), out);
+    out += v;
+}
+
+template <typename T>
+void get_atom(T& v, const char*& p, const char* e);
+
+template <>
+void get_atom(Int& v, const char*& p, const char* e) {
+    v = unzigzag(get_varint(p, e));
+}
+
+template <>
+void get_atom(UInt& v, const char*& p, const char* e) {
+    v = get_varint(p, e);
+}
+
+template <>
+void get_atom(Real& v, const char*& p, const char* e) {
+
+    if ((size_t)(e - p) < sizeof(Real))
+        throw std::runtime_error("Malformed wire format input.");
+
+    ::memcpy(&v, p, sizeof(Real));
+    p += sizeof(Real);
+}
+
+template <>
+void get_atom(std::string& v, const char*& p, const char* e) {
+
+    UInt n = get_varint(p, e);
+
+    if ((UInt)(e - p) < n)
+        throw std::runtime_error("Malformed wire format input.");
+
+    v.assign(p, n);
+    p += n;
+}
+
+template <bool SORTED>
+struct Codec {
+
+    template <typename T>
+    static void put_array(const obj::Object* o, std::string& out) {
+
+        const std::vector<T>& v = obj::get< obj::ArrayAtom<T> >(o).v;
+
+        put_varint(v.size(), out);
+
+        for (const T& x : v) {
+            put_atom(x, out);
+        }
+    }
+
+    template <typename T>
+    static void get_array(obj::Object* o, const char*& p, const char* e) {
+
+        std::vector<T>& v = obj::get< obj::ArrayAtom<T> >(o).v;
+
+        v.resize(get_varint(p, e));
+
+        for (size_t i = 0; i < v.size(); ++i) {
+            T x;
+            get_atom(x, p, e);
+            v[i] = x;
+        }
+    }
+
+    static void put(const Type& t, const obj::Object* o, std::string& out) {
+
+        switch (t.type) {
+        case Type::ATOM:
+            switch (t.atom) {
+            case Type::INT: put_atom(obj::get<obj::Int>(o).v, out); break;
+            case Type::UINT: put_atom(obj::get<obj::UInt>(o).v, out); break;
+            case Type::REAL: put_atom(obj::get<obj::Real>(o).v, out); break;
+            case Type::STRING: put_atom(obj::get<obj::String>(o).v, out); break;
+            }
+            break;
+
+        case Type::TUP: {
+            const obj::Tuple& tup = obj::get<obj::Tuple>(o);
+
+            for (size_t i = 0; i < t.tuple->size(); ++i) {
+                put((*t.tuple)[i], tup.v[i], out);
+            }
+            break;
+        }
+
+        case Type::ARR: {
+            const Type& et = (*t.tuple)[0];
+
+            if (et.type == Type::ATOM) {
+                switch (et.atom) {
+                case Type::INT: put_array<Int>(o, out); break;
+                case Type::UINT: put_array<UInt>(o, out); break;
+                case Type::REAL: put_array<Real>(o, out); break;
+                case Type::STRING: put_array<std::string>(o, out); break;
+                }
+
+            } else {
+                const obj::ArrayObject& arr = obj::get<obj::ArrayObject>(o);
+
+                put_varint(arr.v.size(), out);
+
+                for (const obj::Object* x : arr.v) {
+                    put(et, x, out);
+                }
+            }
+            break;
+        }
+
+        case Type::MAP: {
+            const obj::MapObject<SORTED>& map = obj::get< obj::MapObject<SORTED> >(o);
+
+            put_varint(map.v.size(), out);
+
+            for (const auto& x : map.v) {
+                put((*t.tuple)[0], x.first, out);
+                put((*t.tuple)[1], x.second, out);
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("Cannot write a " + Type::print(t) + " in wire format.");
+        }
+    }
+
+    // Decodes into an object made with obj::make() for the same type.
+    static void get(const Type& t, obj::Object* o, const char*& p, const char* e) {
+
+        switch (t.type) {
+        case Type::ATOM:
+            switch (t.atom) {
+            case Type::INT: get_atom(obj::get<obj::Int>(o).v, p, e); break;
+            case Type::UINT: get_atom(obj::get<obj::UInt>(o).v, p, e); break;
+            case Type::REAL: get_atom(obj::get<obj::Real>(o).v, p, e); break;
+            case Type::STRING: get_atom(obj::get<obj::String>(o).v, p, e); break;
+            }
+            break;
+
+        case Type::TUP: {
+            obj::Tuple& tup = obj::get<obj::Tuple>(o);
+
+            for (size_t i = 0; i < t.tuple->size(); ++i) {
+                get((*t.tuple)[i], tup.v[i], p, e);
+            }
+            break;
+        }
+
+        case Type::ARR: {
+            const Type& et = (*t.tuple)[0];
+
+            if (et.type == Type::ATOM) {
+                switch (et.atom) {
+                case Type::INT: get_array<Int>(o, p, e); break;
+                case Type::UINT: get_array<UInt>(o, p, e); break;
+                case Type::REAL: get_array<Real>(o, p, e); break;
+                case Type::STRING: get_array<std::string>(o, p, e); break;
+                }
+
+            } else {
+                obj::ArrayObject& arr = obj::get<obj::ArrayObject>(o);
+                arr.clear();
+
+                UInt n = get_varint(p, e);
+
+                for (UInt i = 0; i < n; ++i) {
+                    obj::Object* x = obj::make<SORTED>(et);
+                    get(et, x, p, e);
+                    arr.v.push_back(x);
+                }
+            }
+            break;
+        }
+
+        case Type::MAP: {
+            obj::MapObject<SORTED>& map = obj::get< obj::MapObject<SORTED> >(o);
+            map.clear();
+
+            UInt n = get_varint(p, e);
+
+            for (UInt i = 0; i < n; ++i) {
+                obj::Object* k = obj::make<SORTED>((*t.tuple)[0]);
+                obj::Object* v = obj::make<SORTED>((*t.tuple)[1]);
+                get((*t.tuple)[0], k, p, e);
+                get((*t.tuple)[1], v, p, e);
+                map.v[k] = v;
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("Cannot read a " + Type::print(t) + " in wire format.");
+        }
+    }
+};
+
+} // namespace wire
+
+// Writes a result in wire format to stdout.
+template <bool SORTED>
+void write_wire(const Type& t, obj::Object* result) {
+
+    Type et = wrap_seq(t).tuple->at(0);
+    obj::Object* seq = result;
+    std::unique_ptr<obj::Object> holder;
+
+    if (t.type != Type::SEQ) {
+        holder.reset((functions().seqmaker)(t));
+        holder->wrap(result);
+        seq = holder.get();
+    }
+
+    std::string out(wire::MAGIC, wire::MAGIC_SIZE);
+    wire::put_type(et, out);
+
+    std::string elem;
+
+    while (1) {
+
+        obj::Object* x = seq->next();
+
+        if (!x) break;
+
+        elem.clear();
+        wire::Codec<SORTED>::put(et, x, elem);
+
+        wire::put_varint(elem.size(), out);
+        out += elem;
+
+        if (out.size() >= obj::Printer::BUFSIZE) {
+            fwrite(out.data(), sizeof(char), out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    fwrite(out.data(), sizeof(char), out.size(), stdout);
+}
+
+// Wire format input: the element type is read from the header before the program
+// is compiled, and becomes the type of '@'.
+struct WireSource {
+
+    funcs::Linereader reader;
+    Type type;
+
+#ifdef _REENTRANT
+    std::mutex mutex;
+#endif
+
+    WireSource(std::istream& in) : reader(in) {
+        header();
+    }
+
+    WireSource(const std::string& fname) : reader(fname) {
+        header();
+    }
+
+    void header() {
+
+        // Wire format input is never split into records.
+        reader.recsize = 0;
+
+        std::string magic;
+
+        if (!reader.getbytes(magic, wire::MAGIC_SIZE) || magic != std::string(wire::MAGIC, wire::MAGIC_SIZE))
+            throw std::runtime_error("The input is not in wire format (see the '-w' option).");
+
+        // The type is read one byte at a time, since its length is not known in advance.
+        std::string buf;
+
+        while (1) {
+
+            const char* p = buf.data();
+            const char* e = p + buf.size();
+
+            try {
+                type = wire::get_type(p, e);
+                return;
+
+            } catch (std::exception&) {
+
+                int c = reader.getbyte();
+
+                if (c < 0)
+                    throw std::runtime_error("Malformed wire format input.");
+
+                buf += (char)c;
+            }
+        }
+    }
+
+    // Reads the bytes of the next element.
+    bool frame(std::string& out) {
+
+#ifdef _REENTRANT
+        std::lock_guard<std::mutex> l(mutex);
+#endif
+
+        UInt n = 0;
+        unsigned int shift = 0;
+
+        while (1) {
+
+            int c = reader.getbyte();
+
+            if (c < 0) {
+
+                if (shift == 0)
+                    return false;
+
+                throw std::runtime_error("Malformed wire format input.");
+            }
+
+            n |= (UInt)(c & 0x7F) << shift;
+
+            if (!(c & 0x80))
+                break;
+
+            shift += 7;
+        }
+
+        if (n == 0) {
+            out.clear();
+            return true;
+        }
+
+        if (!reader.getbytes(out, n))
+            throw std::runtime_error("Malformed wire format input.");
+
+        return true;
+    }
+};
+
+template <bool SORTED>
+struct SeqWire : public obj::SeqBase {
+
+    std::shared_ptr<WireSource> source;
+    obj::Object* holder;
+    std::string buf;
+
+    SeqWire(std::shared_ptr<WireSource> s) : source(s) {
+        holder = obj::make<SORTED>(source->type);
+    }
+
+    ~SeqWire() {
+        delete holder;
+    }
+
+    obj::Object* next() {
+
+        if (!source->frame(buf))
+            return nullptr;
+
+        const char* p = buf.data();
+        const char* e = p + buf.size();
+
+        wire::Codec<SORTED>::get(source->type, holder, p, e);
+        return holder;
+    }
+};
+
+bool& wire_input() {
+    static bool ret = false;
+    return ret;
+}
+
+bool& wire_output() {
+    static bool ret = false;
+    return ret;
+}
+
+std::shared_ptr<WireSource> open_wire(const std::vector<std::string>& infiles) {
+
+    if (infiles.size() > 1)
+        throw std::runtime_error("Wire format input ('-W') reads a single input stream.");
+
+    if (infiles.empty())
+        return std::make_shared<WireSource>(std::cin);
+
+    return std::make_shared<WireSource>(infiles[0]);
+}
+
+} // namespace tab
+
+#endif